@@ -0,0 +1,83 @@
+#
+# Copyright 2020, Data61, CSIRO (ABN 41 687 119 230)
+#
+# SPDX-License-Identifier: GPL-2.0-only
+#
+"""
+Parse and rewrite the ELF header and program headers of the ELF files the
+ELF-loader gets in its payload, for the image build helper scripts.
+
+THIS IS NOT A STABLE API.  Use from the helper scripts only.
+"""
+
+import struct
+
+PT_LOAD = 1
+
+EHDR_FIELDS = ('e_ident', 'e_type', 'e_machine', 'e_version', 'e_entry',
+               'e_phoff', 'e_shoff', 'e_flags', 'e_ehsize', 'e_phentsize',
+               'e_phnum', 'e_shentsize', 'e_shnum', 'e_shstrndx')
+
+ELF_CLASSES = {
+    1: (struct.Struct('<16sHHIIIIIHHHHHH'),
+        struct.Struct('<IIIIIIII'),
+        ('p_type', 'p_offset', 'p_vaddr', 'p_paddr', 'p_filesz', 'p_memsz',
+         'p_flags', 'p_align')),
+    2: (struct.Struct('<16sHHIQQQIHHHHHH'),
+        struct.Struct('<IIQQQQQQ'),
+        ('p_type', 'p_flags', 'p_offset', 'p_vaddr', 'p_paddr', 'p_filesz',
+         'p_memsz', 'p_align')),
+}
+
+
+class ElfHeaders:
+    """
+    The ELF header and program headers of a little endian ELF file.  The
+    program headers are available as a list of dicts in `segments`.
+    """
+
+    def __init__(self, elf: bytes):
+        if elf[:4] != b'\x7fELF':
+            raise ValueError('not an ELF file')
+        if elf[5] != 1:
+            raise ValueError('only little endian ELF files are supported')
+        if elf[4] not in ELF_CLASSES:
+            raise ValueError('unknown ELF class {}'.format(elf[4]))
+        (self.ehdr, self.phdr, self.phdr_fields) = ELF_CLASSES[elf[4]]
+        if len(elf) < self.ehdr.size:
+            raise ValueError('ELF header exceeds the file')
+
+        self.header = dict(zip(EHDR_FIELDS, self.ehdr.unpack_from(elf)))
+        self.entry = self.header['e_entry']
+        phoff = self.header['e_phoff']
+        phentsize = self.header['e_phentsize']
+        phnum = self.header['e_phnum']
+        if phentsize < self.phdr.size:
+            raise ValueError('program header size {} too small'.format(phentsize))
+        if phoff + phnum * phentsize > len(elf):
+            raise ValueError('program headers exceed the file')
+
+        self.phdr_table = elf[phoff:phoff + phnum * phentsize]
+        self.segments = [
+            dict(zip(self.phdr_fields,
+                     self.phdr.unpack_from(self.phdr_table, i * phentsize)))
+            for i in range(phnum)]
+
+    def pack(self, segments: list = None) -> bytes:
+        """
+        Return the ELF header followed right behind by the program header
+        table, with `segments` in place of the original program headers if
+        given.  The section headers are dropped.
+        """
+        if segments is None:
+            segments = self.segments
+        header = dict(self.header, e_phoff=self.ehdr.size, e_shoff=0,
+                      e_ehsize=self.ehdr.size, e_shnum=0, e_shstrndx=0)
+        out = bytearray(self.ehdr.pack(*(header[f] for f in EHDR_FIELDS)))
+        # Anything past the fields we know of is kept as it is.
+        phentsize = self.header['e_phentsize']
+        for (i, seg) in enumerate(segments):
+            entry = bytearray(self.phdr_table[i * phentsize:(i + 1) * phentsize])
+            self.phdr.pack_into(entry, 0, *(seg[f] for f in self.phdr_fields))
+            out += entry
+        return bytes(out)
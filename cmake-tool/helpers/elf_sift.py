@@ -12,6 +12,7 @@ THIS IS NOT A STABLE API.  Use as a script, not a module.
 
 import argparse
 import elftools.elf.elffile
+import io
 import sys
 
 from typing import BinaryIO
@@ -27,13 +28,34 @@ def get_aligned_size(n: int) -> int:
     return n if n % 4096 == 0 else ((n // 4096) + 1) * 4096
 
 
+# Images compressed by `lz4_image.py` start with this magic and a header of
+# this size, followed by the ELF header and program headers of the original file.
+LZ4_IMAGE_MAGIC = b'seL4LZ4\0'
+LZ4_IMAGE_HEADER_SIZE = 24
+
+
+def get_elf_headers(elf_file: BinaryIO) -> BinaryIO:
+    """
+    Return an ELF file object for `elf_file` that can be passed to pyelftools.
+    For a compressed image, this only contains the headers of the original ELF
+    file, which describe the decompressed segments.
+    """
+    magic = elf_file.read(len(LZ4_IMAGE_MAGIC))
+    if magic == LZ4_IMAGE_MAGIC:
+        elf_file.seek(LZ4_IMAGE_HEADER_SIZE)
+        return io.BytesIO(elf_file.read())
+
+    elf_file.seek(0)
+    return elf_file
+
+
 def get_memory_usage(elf_file: BinaryIO, align: bool) -> int:
     """
     Return the size in bytes occuped in memory of the loadable ELF segments from
     the ELF object file `elf_file`.
     """
 
-    elf = elftools.elf.elffile.ELFFile(elf_file)
+    elf = elftools.elf.elffile.ELFFile(get_elf_headers(elf_file))
 
     # We only care about loadable segments (p_type is "PT_LOAD"), and we
     # want the size in memory of those segments (p_memsz), which can be
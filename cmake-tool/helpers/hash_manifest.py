@@ -0,0 +1,116 @@
+#!/usr/bin/env python3
+#
+# Copyright 2020, Data61, CSIRO (ABN 41 687 119 230)
+#
+# SPDX-License-Identifier: GPL-2.0-only
+#
+"""
+Generate the chunked hash manifest of an ELF file for the ELF-loader.
+
+THIS IS NOT A STABLE API.  Use as a script, not a module.
+"""
+
+import argparse
+import hashlib
+import struct
+import sys
+
+from elf_headers import ElfHeaders, PT_LOAD
+
+# Keep in sync with elfloader-tool/src/hash_manifest.h.
+HASH_MANIFEST_MAGIC = b'seL4HMF\0'
+HASH_MANIFEST_VERSION = 1
+HASH_MANIFEST_HEADER = struct.Struct('<8sIIII')
+# Program header fields that determine where and how the image is loaded.
+HASH_MANIFEST_PHDR = struct.Struct('<IQQQQ')
+HASH_MANIFEST_ENTRY = struct.Struct('<Q')
+
+ALGORITHMS = {
+    'sha256': hashlib.sha256,
+    'md5': hashlib.md5,
+    'blake2s': hashlib.blake2s,
+}
+
+
+def get_manifest(elf: bytes, algorithm: str, chunk_size: int) -> bytes:
+    """
+    Return the hash manifest of the ELF file `elf`.  It contains a digest of
+    the program header fields the ELF-loader uses and the entry point, followed
+    by a digest of each chunk of the file data of the loadable segments.  The
+    chunks start anew with every segment.
+    """
+    new_hash = ALGORITHMS[algorithm]
+    elf_headers = ElfHeaders(elf)
+    (entry, segments) = (elf_headers.entry, elf_headers.segments)
+
+    headers = new_hash()
+    chunks = []
+    for seg in segments:
+        headers.update(HASH_MANIFEST_PHDR.pack(seg['p_type'], seg['p_paddr'],
+                                               seg['p_vaddr'], seg['p_filesz'],
+                                               seg['p_memsz']))
+        if seg['p_type'] != PT_LOAD:
+            continue
+        if seg['p_offset'] + seg['p_filesz'] > len(elf):
+            raise ValueError('segment exceeds the file')
+        data = elf[seg['p_offset']:seg['p_offset'] + seg['p_filesz']]
+        for start in range(0, len(data), chunk_size):
+            chunks.append(new_hash(data[start:start + chunk_size]).digest())
+    headers.update(HASH_MANIFEST_ENTRY.pack(entry))
+
+    manifest = HASH_MANIFEST_HEADER.pack(HASH_MANIFEST_MAGIC,
+                                         HASH_MANIFEST_VERSION,
+                                         headers.digest_size, chunk_size,
+                                         len(chunks))
+    return manifest + headers.digest() + b''.join(chunks)
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(
+        formatter_class=argparse.RawDescriptionHelpFormatter,
+        description="""
+Generate the chunked hash manifest of an ELF file for the ELF-loader, and the
+digest of the manifest that serves as the single top hash of the image.
+
+Only the file data of the loadable segments is covered by the chunk digests,
+symbol tables and other data that is not loaded are not hashed.  The ELF-loader
+checks every chunk when it is loaded and stops at the first bad one.
+""")
+    parser.add_argument('elf_file', type=str,
+                        help='ELF file to generate the manifest for')
+    parser.add_argument('-o', '--output', metavar='FILE', type=str,
+                        required=True, help='manifest to write')
+    parser.add_argument('--root', metavar='FILE', type=str, required=True,
+                        help='file to write the digest of the manifest to')
+    parser.add_argument('--algorithm', choices=sorted(ALGORITHMS),
+                        default='sha256', help='hash algorithm to use')
+    parser.add_argument('--chunk-size', metavar='BYTES', type=int,
+                        default=64 * 1024, help='size of the hashed chunks')
+    args = parser.parse_args()
+
+    if args.chunk_size <= 0 or args.chunk_size > 0xffffffff:
+        sys.stderr.write('{}: invalid chunk size {}\n'
+                         .format(sys.argv[0], args.chunk_size))
+        return 1
+
+    with open(args.elf_file, 'rb') as f:
+        elf = f.read()
+
+    try:
+        manifest = get_manifest(elf, args.algorithm, args.chunk_size)
+    except ValueError as e:
+        sys.stderr.write('{}: file "{}": {}\n'
+                         .format(sys.argv[0], args.elf_file, e))
+        return 1
+
+    with open(args.output, 'wb') as f:
+        f.write(manifest)
+
+    with open(args.root, 'wb') as f:
+        f.write(ALGORITHMS[args.algorithm](manifest).digest())
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
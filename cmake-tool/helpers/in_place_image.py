@@ -0,0 +1,141 @@
+#!/usr/bin/env python3
+#
+# Copyright 2020, Data61, CSIRO (ABN 41 687 119 230)
+#
+# SPDX-License-Identifier: GPL-2.0-only
+#
+"""
+Lay out an ELF file so the ELF-loader can run it right where it is in its
+payload archive.
+
+THIS IS NOT A STABLE API.  Use as a script, not a module.
+"""
+
+import argparse
+import os
+import sys
+
+from elf_headers import ElfHeaders, PT_LOAD
+
+# Size of a "newc" CPIO header, the name and the data of a member are padded
+# to 4 bytes.
+CPIO_NEWC_HEADER_SIZE = 110
+
+
+def cpio_align(size: int) -> int:
+    return (size + 3) & ~3
+
+
+def cpio_header_size(name: str) -> int:
+    """
+    Return the size of the header and name of the archive member `name`.
+    """
+    return cpio_align(CPIO_NEWC_HEADER_SIZE + len(name.encode()) + 1)
+
+
+def cpio_member_size(name: str, data_size: int) -> int:
+    """
+    Return the size of the archive member `name` with `data_size` bytes of data.
+    """
+    return cpio_header_size(name) + cpio_align(data_size)
+
+
+def lay_out(elf: bytes, archive_offset: int, page_bits: int) -> bytes:
+    """
+    Return `elf` with the file data of its loadable segments placed so that
+    the file has the same layout as the image in memory, starting at a page
+    boundary if the file data is at `archive_offset` in a page aligned archive.
+    The file is padded to hold the whole image including its bss, followed by a
+    page for the ELF-loader to put the program headers in. The section headers
+    are dropped.
+    """
+    elf_headers = ElfHeaders(elf)
+    segments = elf_headers.segments
+    sized = [s for s in segments if s['p_memsz'] > 0]
+    if not sized:
+        raise ValueError('no segments')
+    # Same as elf_getMemoryBounds()
+    min_vaddr = min(s['p_vaddr'] for s in sized)
+    max_vaddr = max(s['p_vaddr'] + s['p_memsz'] for s in sized)
+
+    loads = [s for s in segments if s['p_type'] == PT_LOAD]
+    vaddrs = [s['p_vaddr'] for s in loads]
+    if vaddrs != sorted(vaddrs):
+        raise ValueError('loadable segments are not sorted')
+
+    page_size = 1 << page_bits
+    headers_size = len(elf_headers.pack())
+    # File offset of the start of the image.
+    base = headers_size + (-(archive_offset + headers_size) % page_size)
+    image_size = (max_vaddr - min_vaddr + page_size - 1) & ~(page_size - 1)
+
+    out = bytearray(base + image_size + page_size)
+    new_segments = [dict(s) for s in segments]
+    for (s, new) in zip(segments, new_segments):
+        if s['p_type'] == PT_LOAD:
+            if s['p_offset'] + s['p_filesz'] > len(elf):
+                raise ValueError('segment exceeds the file')
+            new['p_offset'] = base + (s['p_vaddr'] - min_vaddr)
+            out[new['p_offset']:new['p_offset'] + s['p_filesz']] = \
+                elf[s['p_offset']:s['p_offset'] + s['p_filesz']]
+            continue
+        # Other segments are moved along with the loadable segment they are
+        # part of, if any.
+        for load in loads:
+            if (load['p_offset'] <= s['p_offset'] and
+                    s['p_offset'] + s['p_filesz'] <= load['p_offset'] + load['p_filesz']):
+                new['p_offset'] = (s['p_offset'] - load['p_offset'] +
+                                   base + (load['p_vaddr'] - min_vaddr))
+                break
+
+    out[0:headers_size] = elf_headers.pack(new_segments)
+    return bytes(out)
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(
+        formatter_class=argparse.RawDescriptionHelpFormatter,
+        description="""
+Lay out an ELF file so that the ELF-loader can run it in place, without copying
+its segments out of the payload archive.  The file data of the loadable
+segments is placed at the same offsets as the segments have in memory, starting
+at a page boundary in the archive, and the file is padded to cover the bss.
+
+The archive must be page aligned in the ELF-loader, and the members in front
+of the image must be given with `--after` in archive order.
+""")
+    parser.add_argument('elf_file', type=str,
+                        help='ELF file to lay out')
+    parser.add_argument('-o', '--output', metavar='FILE', type=str,
+                        required=True,
+                        help='file to write (may be elf_file)')
+    parser.add_argument('--after', metavar='FILE', type=str, nargs='*',
+                        default=[],
+                        help='archive members in front of the image')
+    parser.add_argument('--page-bits', metavar='BITS', type=int, default=12,
+                        help='log2 of the page size the image is aligned to')
+    args = parser.parse_args()
+
+    archive_offset = sum(cpio_member_size(os.path.basename(f),
+                                          os.path.getsize(f))
+                         for f in args.after)
+    archive_offset += cpio_header_size(os.path.basename(args.output))
+
+    with open(args.elf_file, 'rb') as f:
+        elf = f.read()
+
+    try:
+        image = lay_out(elf, archive_offset, args.page_bits)
+    except ValueError as e:
+        sys.stderr.write('{}: file "{}": {}\n'
+                         .format(sys.argv[0], args.elf_file, e))
+        return 1
+
+    with open(args.output, 'wb') as f:
+        f.write(image)
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,123 @@
+#!/usr/bin/env python3
+#
+# Copyright 2020, Data61, CSIRO (ABN 41 687 119 230)
+#
+# SPDX-License-Identifier: GPL-2.0-only
+#
+"""
+Generate the load plan of an ELF file for the ELF-loader.
+
+THIS IS NOT A STABLE API.  Use as a script, not a module.
+"""
+
+import argparse
+import struct
+import sys
+
+from elf_headers import ElfHeaders, PT_LOAD
+
+# Keep in sync with elfloader-tool/src/load_plan.h.
+LOAD_PLAN_MAGIC = b'seL4LPL\0'
+LOAD_PLAN_VERSION = 1
+LOAD_PLAN_HEADER = struct.Struct('<8sIIQQQQQQ')
+LOAD_PLAN_OP = struct.Struct('<IIQQQ')
+LOAD_PLAN_COPY = 1
+LOAD_PLAN_ZERO = 2
+
+
+def get_bounds(segments: list, key: str) -> (int, int):
+    """
+    Return the memory bounds of the image like elf_getMemoryBounds(), `key`
+    selects physical or virtual addresses.
+    """
+    sized = [s for s in segments if s['p_memsz'] > 0]
+    if not sized:
+        raise ValueError('no segments')
+    return (min(s[key] for s in sized),
+            max(s[key] + s['p_memsz'] for s in sized))
+
+
+def get_plan(elf: bytes, page_bits: int) -> bytes:
+    """
+    Return the load plan of the ELF file `elf`, see elfloader-tool/src/load_plan.h
+    for the format. The operations are the same the ELF-loader performs when it
+    unpacks the file without a plan.
+    """
+    elf_headers = ElfHeaders(elf)
+    (entry, segments) = (elf_headers.entry, elf_headers.segments)
+    (min_vaddr, max_vaddr) = get_bounds(segments, 'p_vaddr')
+    (min_paddr, max_paddr) = get_bounds(segments, 'p_paddr')
+
+    image_size = max_vaddr - min_vaddr
+    page_size = 1 << page_bits
+    zero_size = (image_size + page_size - 1) & ~(page_size - 1)
+
+    load = [(i, s) for (i, s) in enumerate(segments) if s['p_type'] == PT_LOAD]
+    for (i, s) in load:
+        if s['p_vaddr'] < min_vaddr or s['p_filesz'] > s['p_memsz']:
+            raise ValueError('segment {} invalid'.format(i))
+        if s['p_offset'] + s['p_filesz'] > len(elf):
+            raise ValueError('segment {} exceeds the file'.format(i))
+    vaddrs = [s['p_vaddr'] for (_, s) in load]
+    is_sorted = (vaddrs == sorted(vaddrs))
+
+    ops = []
+    if not is_sorted:
+        ops.append((LOAD_PLAN_ZERO, 0, 0, 0, zero_size))
+    # Offset up to which the image has been zeroed or loaded.
+    loaded = 0
+    for (i, s) in load:
+        offset = s['p_vaddr'] - min_vaddr
+        if is_sorted and offset > loaded:
+            ops.append((LOAD_PLAN_ZERO, i, 0, loaded, offset - loaded))
+        # Empty copies are kept, the segments of compressed images are read
+        # in program header order.
+        ops.append((LOAD_PLAN_COPY, i, s['p_offset'], offset, s['p_filesz']))
+        loaded = max(loaded, offset + s['p_filesz'])
+    if is_sorted and zero_size > loaded:
+        ops.append((LOAD_PLAN_ZERO, len(segments), 0, loaded, zero_size - loaded))
+
+    plan = LOAD_PLAN_HEADER.pack(LOAD_PLAN_MAGIC, LOAD_PLAN_VERSION, len(ops),
+                                 len(elf), min_vaddr, max_vaddr, min_paddr,
+                                 max_paddr, entry)
+    return plan + b''.join(LOAD_PLAN_OP.pack(*op) for op in ops)
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(
+        formatter_class=argparse.RawDescriptionHelpFormatter,
+        description="""
+Generate the load plan of an ELF file for the ELF-loader.  The plan has the
+memory bounds and the entry point of the image and the list of copy and zero
+operations that unpack it, so the ELF-loader does not have to walk the program
+headers at boot time.
+
+The plan must be generated from the ELF file as it is stored in the archive,
+before it is compressed.
+""")
+    parser.add_argument('elf_file', type=str,
+                        help='ELF file to generate the load plan for')
+    parser.add_argument('-o', '--output', metavar='FILE', type=str,
+                        required=True, help='load plan to write')
+    parser.add_argument('--page-bits', metavar='BITS', type=int, default=12,
+                        help='log2 of the page size the images are aligned to')
+    args = parser.parse_args()
+
+    with open(args.elf_file, 'rb') as f:
+        elf = f.read()
+
+    try:
+        plan = get_plan(elf, args.page_bits)
+    except ValueError as e:
+        sys.stderr.write('{}: file "{}": {}\n'
+                         .format(sys.argv[0], args.elf_file, e))
+        return 1
+
+    with open(args.output, 'wb') as f:
+        f.write(plan)
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
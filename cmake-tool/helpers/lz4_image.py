@@ -0,0 +1,120 @@
+#!/usr/bin/env python3
+#
+# Copyright 2020, Data61, CSIRO (ABN 41 687 119 230)
+#
+# SPDX-License-Identifier: GPL-2.0-only
+#
+"""
+Compress an ELF file for the ELF-loader's payload.
+
+THIS IS NOT A STABLE API.  Use as a script, not a module.
+"""
+
+import argparse
+import struct
+import sys
+
+import lz4.block
+
+from elf_headers import ElfHeaders, PT_LOAD
+
+# Keep in sync with elfloader-tool/src/lz4.h.
+LZ4_IMAGE_MAGIC = b'seL4LZ4\0'
+LZ4_IMAGE_VERSION = 2
+LZ4_IMAGE_BLOCK_STORED = 0x80000000
+LZ4_IMAGE_HEADER = struct.Struct('<8sIIII')
+
+
+def get_elf_headers(elf: bytes) -> (bytes, list):
+    """
+    Return the ELF header and program header table of `elf` as they are put
+    into the compressed image, and a list of (offset, size) tuples of the file
+    data of the loadable segments in program header order.
+
+    The program headers are moved right behind the ELF header, the section
+    headers are dropped.
+    """
+    elf_headers = ElfHeaders(elf)
+    segments = []
+    for (i, seg) in enumerate(elf_headers.segments):
+        if seg['p_type'] == PT_LOAD and seg['p_filesz'] > 0:
+            if seg['p_offset'] + seg['p_filesz'] > len(elf):
+                raise ValueError('segment {} exceeds the file'.format(i))
+            segments.append((seg['p_offset'], seg['p_filesz']))
+
+    headers = elf_headers.pack()
+    headers += bytes(-len(headers) % 8)
+    return (headers, segments)
+
+
+def compress(elf: bytes, block_size: int) -> bytes:
+    """
+    Return the compressed image of the ELF file `elf`, see
+    elfloader-tool/src/lz4.h for the format.
+    """
+    (headers, segments) = get_elf_headers(elf)
+    if len(elf) > 0xffffffff:
+        raise ValueError('file too large')
+    image = bytearray(LZ4_IMAGE_HEADER.pack(LZ4_IMAGE_MAGIC, LZ4_IMAGE_VERSION,
+                                            len(headers), block_size, len(elf)))
+    image += headers
+
+    for (offset, size) in segments:
+        for start in range(offset, offset + size, block_size):
+            block = elf[start:min(start + block_size, offset + size)]
+            data = lz4.block.compress(block, mode='high_compression',
+                                      store_size=False)
+            if len(data) < len(block):
+                image += struct.pack('<I', len(data))
+                image += data
+            else:
+                image += struct.pack('<I', len(block) | LZ4_IMAGE_BLOCK_STORED)
+                image += block
+
+    return bytes(image)
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(
+        formatter_class=argparse.RawDescriptionHelpFormatter,
+        description="""
+Compress the loadable segments of an ELF file with LZ4 for the ELF-loader's
+payload.  The ELF header and program headers are kept uncompressed in front of
+the segment data, so the resulting file can still be inspected by `elf_sift`.
+
+The ELF-loader decompresses the segments straight to their load addresses if
+it was built with `ElfloaderCompressImages`.
+""")
+    parser.add_argument('elf_file', type=str,
+                        help='ELF file to compress')
+    parser.add_argument('-o', '--output', metavar='FILE', type=str,
+                        required=True,
+                        help='compressed image to write (may be elf_file)')
+    parser.add_argument('--block-size', metavar='BYTES', type=int,
+                        default=256 * 1024,
+                        help='size of the independently compressed blocks')
+    args = parser.parse_args()
+
+    if args.block_size <= 0 or args.block_size >= LZ4_IMAGE_BLOCK_STORED:
+        sys.stderr.write('{}: invalid block size {}\n'
+                         .format(sys.argv[0], args.block_size))
+        return 1
+
+    with open(args.elf_file, 'rb') as f:
+        elf = f.read()
+
+    try:
+        image = compress(elf, args.block_size)
+    except ValueError as e:
+        sys.stderr.write('{}: file "{}": {}\n'
+                         .format(sys.argv[0], args.elf_file, e))
+        return 1
+
+    with open(args.output, 'wb') as f:
+        f.write(image)
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
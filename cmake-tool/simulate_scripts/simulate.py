@@ -9,6 +9,25 @@ import subprocess
 import sys
 import argparse
 import time
+import os
+import re
+import json
+import signal
+import selectors
+import statistics
+
+# Serial output that marks the end of a boot phase in benchmark mode. They are
+# searched in order, each one only after the previous one was seen.
+BENCH_MARKERS = [
+    ('loader_start', r'ELF-loader started'),
+    ('enabling_mmu', r'Enabling MMU'),
+    ('kernel_banner', r'Bootstrapping kernel'),
+    ('kernel_done', r'Booting all finished'),
+    ('rootserver', r'\S'),
+]
+
+# Lines of the ELF-loader's boot time summary, see ElfloaderBootTime.
+BOOT_TIME_RECORD = re.compile(r'^  ([a-z ]+?)(?: \d+)?: (\d+) ticks')
 
 
 def parse_args():
@@ -44,10 +63,180 @@ def parse_args():
                         default="")
     parser.add_argument("-r", "--reset-terminal", dest="reset_terminal", action="store_true",
                         help="Reset the terminal after QEMU exists")
+    parser.add_argument('--icount', dest='qemu_sim_icount', type=int, metavar='SHIFT',
+                        help="Run QEMU with -icount shift=SHIFT, so guest time depends only "
+                        "on the number of executed instructions")
+    parser.add_argument('--bench', dest='bench_runs', type=int, metavar='N', default=0,
+                        help="Boot the image N times and report the time to each serial "
+                        "marker as JSON instead of running QEMU interactively")
+    parser.add_argument('--bench-marker', dest='bench_markers', action='append',
+                        metavar='NAME=REGEX', default=[],
+                        help="Serial marker to time, replaces the default markers. Can be "
+                        "given several times, markers are matched in order")
+    parser.add_argument('--bench-timeout', dest='bench_timeout', type=float, default=60,
+                        help="Seconds after which a benchmark run that has not seen all "
+                        "markers is stopped and counted as failed")
+    parser.add_argument('--bench-output', dest='bench_output', type=str, metavar='FILE',
+                        help="Write the benchmark results to FILE instead of stdout")
+    parser.add_argument('--bench-baseline', dest='bench_baseline', type=str, metavar='FILE',
+                        help="Results of an earlier benchmark run to compare the medians with")
+    parser.add_argument('--bench-max-regression', dest='bench_max_regression', type=float,
+                        default=10, metavar='PERCENT',
+                        help="Fail if the median of a phase grew by more than PERCENT "
+                        "against the baseline")
     args = parser.parse_args()
     return args
 
 
+def percentile(values, pct):
+    """
+    Return the `pct` percentile of the non-empty list `values`, interpolating
+    between the closest ranks.
+    """
+    values = sorted(values)
+    pos = (len(values) - 1) * pct / 100
+    low = int(pos)
+    high = min(low + 1, len(values) - 1)
+    return values[low] + (values[high] - values[low]) * (pos - low)
+
+
+def summarize(values):
+    return {
+        'median': statistics.median(values),
+        'p90': percentile(values, 90),
+        'p99': percentile(values, 99),
+        'min': min(values),
+        'max': max(values),
+    }
+
+
+def bench_run(command, markers, timeout):
+    """
+    Boot the image once and return the seconds from starting QEMU to each of
+    `markers`, and the ticks of each phase in the ELF-loader's boot time
+    summary, if it printed one. Returns None if not all markers were seen.
+    """
+    # exec, so that QEMU gets the signal when the run is stopped.
+    proc = subprocess.Popen('exec ' + command, shell=True, stdin=subprocess.DEVNULL,
+                            stdout=subprocess.PIPE, stderr=subprocess.STDOUT)
+    start = time.monotonic()
+    times = {}
+    ticks = {}
+    pending = b''
+    sel = selectors.DefaultSelector()
+    sel.register(proc.stdout, selectors.EVENT_READ)
+
+    try:
+        while len(times) < len(markers):
+            left = start + timeout - time.monotonic()
+            if left <= 0 or not sel.select(left):
+                break
+            data = os.read(proc.stdout.fileno(), 4096)
+            if not data:
+                break
+            now = time.monotonic() - start
+            lines = (pending + data).split(b'\n')
+            pending = lines.pop()
+            for line in lines:
+                line = line.decode(errors='replace').rstrip('\r')
+                match = BOOT_TIME_RECORD.match(line)
+                if match:
+                    ticks[match.group(1)] = ticks.get(match.group(1), 0) + int(match.group(2))
+                if len(times) < len(markers):
+                    (name, regex) = markers[len(times)]
+                    if regex.search(line):
+                        times[name] = now
+    finally:
+        sel.close()
+        proc.send_signal(signal.SIGTERM)
+        try:
+            proc.wait(timeout=5)
+        except subprocess.TimeoutExpired:
+            proc.kill()
+            proc.wait()
+
+    if len(times) < len(markers):
+        notice('run stopped after {} of {} markers\n'.format(len(times), len(markers)))
+        return None
+    return (times, ticks)
+
+
+def bench(args, command):
+    """
+    Run the benchmark mode and return the exit code.
+    """
+    markers = BENCH_MARKERS
+    if args.bench_markers:
+        markers = []
+        for marker in args.bench_markers:
+            (name, sep, regex) = marker.partition('=')
+            if not sep or not name:
+                notice('invalid marker "{}", expected NAME=REGEX\n'.format(marker))
+                return 1
+            markers.append((name, regex))
+    markers = [(name, re.compile(regex)) for (name, regex) in markers]
+
+    runs = []
+    for i in range(args.bench_runs):
+        notice('benchmark run {} of {}\n'.format(i + 1, args.bench_runs))
+        result = bench_run(command, markers, args.bench_timeout)
+        if result:
+            runs.append(result)
+    if not runs:
+        notice('no benchmark run saw all markers\n')
+        return 1
+
+    # Time to each marker, and from each marker to the next one.
+    names = [name for (name, _) in markers]
+    phases = {}
+    for (i, name) in enumerate(names):
+        prev = names[i - 1] if i else None
+        phases[name] = [times[name] - (times[prev] if prev else 0) for (times, _) in runs]
+    results = {
+        'command': command,
+        'icount': args.qemu_sim_icount,
+        'runs': args.bench_runs,
+        'failed_runs': args.bench_runs - len(runs),
+        'markers_s': {name: summarize([times[name] for (times, _) in runs]) for name in names},
+        'phases_s': {name: summarize(values) for (name, values) in phases.items()},
+    }
+    # With -icount the ELF-loader's records don't vary between runs.
+    boot_ticks = [ticks for (_, ticks) in runs if ticks]
+    if boot_ticks:
+        keys = sorted(set().union(*boot_ticks))
+        results['elfloader_ticks'] = {key: summarize([ticks.get(key, 0) for ticks in boot_ticks])
+                                      for key in keys}
+
+    status = 0 if len(runs) == args.bench_runs else 1
+    if args.bench_baseline:
+        with open(args.bench_baseline) as f:
+            baseline = json.load(f)
+        regressions = []
+        for group in ('phases_s', 'elfloader_ticks'):
+            for (name, new) in results.get(group, {}).items():
+                old = baseline.get(group, {}).get(name)
+                if not old or old['median'] <= 0:
+                    continue
+                growth = (new['median'] / old['median'] - 1) * 100
+                if growth > args.bench_max_regression:
+                    regressions.append({'group': group, 'name': name, 'baseline': old['median'],
+                                        'median': new['median'], 'percent': growth})
+        results['regressions'] = regressions
+        for r in regressions:
+            notice('{group} {name}: median {median:g} against {baseline:g}, '
+                   '+{percent:.1f}%\n'.format(**r))
+        if regressions:
+            status = 1
+
+    output = json.dumps(results, indent=2, sort_keys=True) + '\n'
+    if args.bench_output:
+        with open(args.bench_output, 'w') as f:
+            f.write(output)
+    else:
+        sys.stdout.write(output)
+    return status
+
+
 def notice(message):
     # Don't call this without initialising `progname`.
     assert (progname)
@@ -79,9 +268,13 @@ if __name__ == "__main__":
 
     qemu_sim_mem_size_entry = "-m size=" + args.qemu_sim_mem_size
 
+    qemu_sim_icount_entry = ""
+    if args.qemu_sim_icount is not None:
+        qemu_sim_icount_entry = "-icount shift={}".format(args.qemu_sim_icount)
+
     qemu_simulate_command_opts = [args.qemu_sim_binary, qemu_sim_machine_entry, qemu_sim_cpu_entry, args.qemu_sim_graphic_opt,
-                                  args.qemu_sim_serial_opt, qemu_sim_mem_size_entry, args.qemu_sim_extra_args, qemu_sim_images_entry,
-                                  qemu_gdbserver_command]
+                                  args.qemu_sim_serial_opt, qemu_sim_mem_size_entry, qemu_sim_icount_entry,
+                                  args.qemu_sim_extra_args, qemu_sim_images_entry, qemu_gdbserver_command]
     qemu_simulate_command = " ".join(qemu_simulate_command_opts)
 
     notice('QEMU command: ' + qemu_simulate_command)
@@ -89,6 +282,12 @@ if __name__ == "__main__":
     if args.dry_run:
         exit()
 
+    if args.bench_runs:
+        if qemu_gdbserver_command != "":
+            notice('benchmark mode cannot wait for GDB\n')
+            sys.exit(1)
+        sys.exit(bench(args, qemu_simulate_command))
+
     if qemu_gdbserver_command != "":
         notice('waiting for GDB on port 1234...')
 
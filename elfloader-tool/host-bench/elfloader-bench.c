@@ -0,0 +1,478 @@
+/*
+ * Copyright 2020, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ */
+
+/*
+ * Host benchmark of the ELF-loader's string, printf and hash code. Everything
+ * is checked against libc or known digests first, then the throughput is
+ * measured and printed as JSON on stdout. The exit code is non-zero if any
+ * check failed.
+ *
+ * usage: elfloader-bench [--quick]
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../src/crypt_sha256.h"
+#include "../src/crypt_md5.h"
+#include "../src/crypt_blake2s.h"
+
+/* The ELF-loader functions, renamed when building the library. */
+void *elfloader_memcpy(void *dest, const void *src, size_t n);
+void *elfloader_memmove(void *dest, const void *src, size_t n);
+void *elfloader_memset(void *s, int c, size_t n);
+int elfloader_sprintf(char *buff, const char *format, ...);
+
+/* Output of the ELF-loader's printf(), which is not benchmarked. */
+int plat_console_putchar(unsigned int c)
+{
+    return (int)c;
+}
+
+int plat_console_write(char const *buf, size_t len)
+{
+    (void)buf;
+    return (int)len;
+}
+
+#define ARRAY_SIZE(a)   (sizeof(a) / sizeof((a)[0]))
+#define MAX_SIZE        (1024 * 1024)
+#define ALIGN_SLACK     64
+#define GUARD           64
+
+/* Minimum time per measurement in seconds, --quick lowers it. */
+static double min_time = 0.05;
+static int failures;
+
+static unsigned char *buf_src;
+static unsigned char *buf_dest;
+static unsigned char *buf_ref;
+
+static void fail(char const *what)
+{
+    fprintf(stderr, "FAIL: %s\n", what);
+    failures++;
+}
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static unsigned char pattern(size_t i)
+{
+    return (unsigned char)(i * 7 + (i >> 8) + 1);
+}
+
+/*
+ * String functions
+ */
+
+typedef void *copy_fn(void *dest, const void *src, size_t n);
+typedef void *set_fn(void *s, int c, size_t n);
+
+struct string_op {
+    char const *name;
+    copy_fn *loader_copy;
+    copy_fn *libc_copy;
+    set_fn *loader_set;
+    set_fn *libc_set;
+};
+
+static struct string_op const string_ops[] = {
+    { "memcpy", elfloader_memcpy, memcpy, NULL, NULL },
+    { "memmove", elfloader_memmove, memmove, NULL, NULL },
+    { "memset", NULL, NULL, elfloader_memset, memset },
+};
+
+static size_t const check_sizes[] = {
+    0, 1, 2, 3, 4, 7, 8, 9, 15, 16, 17, 31, 32, 33, 63, 64, 65, 127, 128, 129,
+    255, 256, 257, 1000, 4096, 4099
+};
+
+static size_t const bench_sizes[] = { 16, 64, 256, 4096, 65536, MAX_SIZE };
+
+static struct {
+    size_t dest;
+    size_t src;
+} const bench_align[] = {
+    { 0, 0 }, { 1, 1 }, { 0, 1 }, { 1, 0 }, { 0, 4 }, { 3, 5 },
+};
+
+static void run_string_op(struct string_op const *op, int loader,
+                          size_t dest, size_t src, size_t n)
+{
+    if (op->loader_copy) {
+        (loader ? op->loader_copy : op->libc_copy)(buf_dest + dest, buf_src + src, n);
+    } else {
+        (loader ? op->loader_set : op->libc_set)(buf_dest + dest, 0, n);
+    }
+}
+
+static void check_string_op(struct string_op const *op)
+{
+    size_t const len = GUARD + MAX_SIZE + ALIGN_SLACK + GUARD;
+
+    for (size_t k = 0; k < ARRAY_SIZE(check_sizes); k++) {
+        size_t n = check_sizes[k];
+        for (size_t d = 0; d < 16; d++) {
+            for (size_t s = 0; s < 16; s++) {
+                unsigned char *dest = buf_dest + GUARD + d;
+                unsigned char *ref = buf_ref + GUARD + d;
+                unsigned char const *src = buf_src + GUARD + s;
+                void *ret;
+
+                memset(buf_dest, 0xa5, len);
+                memset(buf_ref, 0xa5, len);
+                if (op->loader_copy) {
+                    ret = op->loader_copy(dest, src, n);
+                    op->libc_copy(ref, src, n);
+                } else {
+                    /* memset only depends on the dest alignment */
+                    if (s != 0) {
+                        break;
+                    }
+                    ret = op->loader_set(dest, (int)(n + d), n);
+                    op->libc_set(ref, (int)(n + d), n);
+                }
+                if (ret != dest || memcmp(buf_dest, buf_ref, len) != 0) {
+                    fprintf(stderr, "%s: size %zu, dest offset %zu, src offset %zu\n",
+                            op->name, n, d, s);
+                    fail("string function result differs from libc");
+                    return;
+                }
+            }
+        }
+    }
+
+    if (op->loader_copy == elfloader_memmove) {
+        /* Overlapping moves in both directions */
+        for (size_t k = 0; k < ARRAY_SIZE(check_sizes); k++) {
+            size_t n = check_sizes[k];
+            for (size_t shift = 1; shift < 20; shift++) {
+                for (int up = 0; up < 2; up++) {
+                    unsigned char *base = buf_dest + GUARD;
+                    unsigned char *from = up ? base : base + shift;
+                    unsigned char *to = up ? base + shift : base;
+
+                    for (size_t i = 0; i < n + shift; i++) {
+                        base[i] = buf_ref[GUARD + i] = pattern(i);
+                    }
+                    elfloader_memmove(to, from, n);
+                    memmove(buf_ref + GUARD + (to - base),
+                            buf_ref + GUARD + (from - base), n);
+                    if (memcmp(base, buf_ref + GUARD, n + shift) != 0) {
+                        fprintf(stderr, "memmove: size %zu, shift %s%zu\n",
+                                n, up ? "+" : "-", shift);
+                        fail("overlapping memmove differs from libc");
+                        return;
+                    }
+                }
+            }
+        }
+    }
+}
+
+/* Returns MB/s of the function in one configuration. */
+static double bench_string_op(struct string_op const *op, int loader,
+                              size_t dest, size_t src, size_t n)
+{
+    unsigned long iters = 1;
+
+    for (;;) {
+        double start = now();
+        for (unsigned long i = 0; i < iters; i++) {
+            run_string_op(op, loader, dest, src, n);
+        }
+        double elapsed = now() - start;
+        if (elapsed >= min_time) {
+            return (double)n * (double)iters / elapsed / 1e6;
+        }
+        iters *= (elapsed > min_time / 16) ? 2 : 16;
+    }
+}
+
+static void bench_strings(void)
+{
+    int first = 1;
+
+    printf("  \"string\": [");
+    for (size_t k = 0; k < ARRAY_SIZE(string_ops); k++) {
+        struct string_op const *op = &string_ops[k];
+        check_string_op(op);
+
+        for (size_t j = 0; j < ARRAY_SIZE(bench_sizes); j++) {
+            for (size_t a = 0; a < ARRAY_SIZE(bench_align); a++) {
+                size_t n = bench_sizes[j];
+                size_t dest = bench_align[a].dest;
+                size_t src = bench_align[a].src;
+                if (!op->loader_copy && src != 0) {
+                    continue;
+                }
+                double loader = bench_string_op(op, 1, dest, src, n);
+                double libc = bench_string_op(op, 0, dest, src, n);
+                printf("%s\n    {\"function\": \"%s\", \"size\": %zu, "
+                       "\"dest_offset\": %zu, \"src_offset\": %zu, "
+                       "\"mb_per_s\": %.1f, \"libc_mb_per_s\": %.1f}",
+                       first ? "" : ",", op->name, n, dest, src, loader, libc);
+                first = 0;
+            }
+        }
+    }
+    printf("\n  ],\n");
+}
+
+/*
+ * Hashes
+ */
+
+struct hash_alg {
+    char const *name;
+    size_t digest_size;
+    /* Also copies the data to 'copy' with *_update_copy() if it isn't NULL */
+    void (*digest)(void const *data, size_t len, size_t chunk, uint8_t *copy,
+                   uint8_t *out);
+    /* Digest of "abc" */
+    uint8_t abc[32];
+};
+
+static void sha256_digest(void const *data, size_t len, size_t chunk, uint8_t *copy,
+                          uint8_t *out)
+{
+    sha256_t s;
+    sha256_init(&s);
+    for (size_t off = 0; off < len; off += chunk) {
+        size_t n = len - off < chunk ? len - off : chunk;
+        if (copy) {
+            sha256_update_copy(&s, copy + off, (uint8_t const *)data + off, n);
+        } else {
+            sha256_update(&s, (uint8_t const *)data + off, n);
+        }
+    }
+    sha256_sum(&s, out);
+}
+
+static void md5_digest(void const *data, size_t len, size_t chunk, uint8_t *copy,
+                       uint8_t *out)
+{
+    md5_t s;
+    md5_init(&s);
+    for (size_t off = 0; off < len; off += chunk) {
+        size_t n = len - off < chunk ? len - off : chunk;
+        if (copy) {
+            md5_update_copy(&s, copy + off, (uint8_t const *)data + off, n);
+        } else {
+            md5_update(&s, (uint8_t const *)data + off, n);
+        }
+    }
+    md5_sum(&s, out);
+}
+
+static void blake2s_digest(void const *data, size_t len, size_t chunk, uint8_t *copy,
+                           uint8_t *out)
+{
+    blake2s_t s;
+    blake2s_init(&s);
+    for (size_t off = 0; off < len; off += chunk) {
+        size_t n = len - off < chunk ? len - off : chunk;
+        if (copy) {
+            blake2s_update_copy(&s, copy + off, (uint8_t const *)data + off, n);
+        } else {
+            blake2s_update(&s, (uint8_t const *)data + off, n);
+        }
+    }
+    blake2s_sum(&s, out);
+}
+
+static struct hash_alg const hash_algs[] = {
+    {
+        "sha256", 32, sha256_digest, {
+            0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea,
+            0x41, 0x41, 0x40, 0xde, 0x5d, 0xae, 0x22, 0x23,
+            0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c,
+            0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad
+        }
+    },
+    {
+        "md5", 16, md5_digest, {
+            0x90, 0x01, 0x50, 0x98, 0x3c, 0xd2, 0x4f, 0xb0,
+            0xd6, 0x96, 0x3f, 0x7d, 0x28, 0xe1, 0x7f, 0x72
+        }
+    },
+    {
+        "blake2s", 32, blake2s_digest, {
+            0x50, 0x8c, 0x5e, 0x8c, 0x32, 0x7c, 0x14, 0xe2,
+            0xe1, 0xa7, 0x2b, 0xa3, 0x4e, 0xeb, 0x45, 0x2f,
+            0x37, 0x45, 0x8b, 0x20, 0x9e, 0xd6, 0x3a, 0x29,
+            0x4d, 0x99, 0x9b, 0x4c, 0x86, 0x67, 0x59, 0x82
+        }
+    },
+};
+
+static void check_hash(struct hash_alg const *alg)
+{
+    uint8_t out[32];
+    uint8_t whole[32];
+
+    alg->digest("abc", 3, 3, NULL, out);
+    if (memcmp(out, alg->abc, alg->digest_size) != 0) {
+        fprintf(stderr, "%s: wrong digest of \"abc\"\n", alg->name);
+        fail("hash differs from the reference digest");
+    }
+
+    /* Feeding the data in pieces must not change the digest. */
+    alg->digest(buf_src, 100000, 100000, NULL, whole);
+    static size_t const chunks[] = { 1, 3, 63, 64, 65, 4096 };
+    for (size_t k = 0; k < ARRAY_SIZE(chunks); k++) {
+        alg->digest(buf_src, 100000, chunks[k], NULL, out);
+        if (memcmp(out, whole, alg->digest_size) != 0) {
+            fprintf(stderr, "%s: chunk size %zu\n", alg->name, chunks[k]);
+            fail("hash depends on the update size");
+        }
+        /* Copying while hashing, to a misaligned destination. */
+        memset(buf_dest, 0, 100001);
+        alg->digest(buf_src, 100000, chunks[k], buf_dest + 1, out);
+        if (memcmp(out, whole, alg->digest_size) != 0 ||
+            memcmp(buf_dest + 1, buf_src, 100000) != 0) {
+            fprintf(stderr, "%s: chunk size %zu\n", alg->name, chunks[k]);
+            fail("copying while hashing differs from hashing and copying");
+        }
+    }
+}
+
+static void bench_hashes(void)
+{
+    printf("  \"hash\": [");
+    for (size_t k = 0; k < ARRAY_SIZE(hash_algs); k++) {
+        struct hash_alg const *alg = &hash_algs[k];
+        uint8_t out[32];
+        unsigned long iters = 0;
+
+        check_hash(alg);
+
+        double start = now();
+        double elapsed;
+        do {
+            alg->digest(buf_src, MAX_SIZE, MAX_SIZE, NULL, out);
+            iters++;
+            elapsed = now() - start;
+        } while (elapsed < min_time);
+        printf("%s\n    {\"algorithm\": \"%s\", \"size\": %d, \"mb_per_s\": %.1f}",
+               k ? "," : "", alg->name, MAX_SIZE,
+               (double)MAX_SIZE * (double)iters / elapsed / 1e6);
+    }
+    printf("\n  ],\n");
+}
+
+/*
+ * printf
+ */
+
+/* Typical lines the ELF-loader prints. Its %p has no "0x" prefix. */
+static void format_image(char *buff, int loader)
+{
+    char const *fmt = "ELF-loading image '%s' to %lx\n  paddr=[%lx..%lx]\n  vaddr=[%llx..%llx]\n";
+    int (*fn)(char *, char const *, ...) = loader ? elfloader_sprintf : sprintf;
+    fn(buff, fmt, "kernel", 0x40000000ul, 0x40000000ul, 0x4023ffful,
+       0xffffff8040000000ull, 0xffffff804023ffffull);
+}
+
+static void format_numbers(char *buff, int loader)
+{
+    char const *fmt = "cpu %d, %u images, %zu bytes, %x, %llu %c%%\n";
+    int (*fn)(char *, char const *, ...) = loader ? elfloader_sprintf : sprintf;
+    fn(buff, fmt, 3, 7u, (size_t)123456789, 0xbeefu, 18446744073709551615ull, 'x');
+}
+
+static struct {
+    char const *name;
+    void (*format)(char *buff, int loader);
+} const formats[] = {
+    { "image", format_image },
+    { "numbers", format_numbers },
+};
+
+static double bench_format(void (*format)(char *, int), int loader)
+{
+    char buff[256];
+    unsigned long iters = 0;
+    double start = now();
+    double elapsed;
+
+    do {
+        for (int i = 0; i < 100; i++) {
+            format(buff, loader);
+        }
+        iters += 100;
+        elapsed = now() - start;
+    } while (elapsed < min_time);
+    return elapsed / (double)iters * 1e9;
+}
+
+static void bench_printf(void)
+{
+    printf("  \"printf\": [");
+    for (size_t k = 0; k < ARRAY_SIZE(formats); k++) {
+        char loader[256];
+        char libc[256];
+
+        /* The loader's sprintf() does not terminate the string. */
+        memset(loader, 0, sizeof(loader));
+        formats[k].format(loader, 1);
+        formats[k].format(libc, 0);
+        if (strcmp(loader, libc) != 0) {
+            fprintf(stderr, "sprintf %s:\n%s\nlibc:\n%s\n", formats[k].name, loader, libc);
+            fail("sprintf output differs from libc");
+        }
+
+        printf("%s\n    {\"format\": \"%s\", \"length\": %zu, \"ns_per_call\": %.1f, "
+               "\"libc_ns_per_call\": %.1f}",
+               k ? "," : "", formats[k].name, strlen(libc),
+               bench_format(formats[k].format, 1), bench_format(formats[k].format, 0));
+    }
+    printf("\n  ],\n");
+}
+
+int main(int argc, char **argv)
+{
+    if (argc == 2 && strcmp(argv[1], "--quick") == 0) {
+        min_time = 0.005;
+    } else if (argc != 1) {
+        fprintf(stderr, "usage: %s [--quick]\n", argv[0]);
+        return 2;
+    }
+
+    size_t len = GUARD + MAX_SIZE + ALIGN_SLACK + GUARD;
+    buf_src = aligned_alloc(64, len);
+    buf_dest = aligned_alloc(64, len);
+    buf_ref = aligned_alloc(64, len);
+    if (!buf_src || !buf_dest || !buf_ref) {
+        fprintf(stderr, "out of memory\n");
+        return 2;
+    }
+    for (size_t i = 0; i < len; i++) {
+        buf_src[i] = pattern(i);
+    }
+
+    printf("{\n  \"pointer_bits\": %zu,\n  \"min_time_s\": %g,\n",
+           sizeof(void *) * 8, min_time);
+    bench_strings();
+    bench_hashes();
+    bench_printf();
+    printf("  \"failures\": %d\n}\n", failures);
+
+    free(buf_src);
+    free(buf_dest);
+    free(buf_ref);
+    return failures ? 1 : 0;
+}
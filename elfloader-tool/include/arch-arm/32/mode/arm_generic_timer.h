@@ -25,3 +25,27 @@ static inline void reset_cntvoff(void)
         printf("Not in hyp mode, cannot reset CNTVOFF_EL2\n");
     }
 }
+
+/* Read the physical counter, the ISB keeps it from being read early. */
+static inline uint64_t read_cntpct(void)
+{
+    uint32_t lo, hi;
+    asm volatile("isb; mrrc p15, 0, %0, %1, c14" : "=r"(lo), "=r"(hi) :: "memory");
+    return ((uint64_t)hi << 32) | lo;
+}
+
+static inline uint32_t read_cntfrq(void)
+{
+    uint32_t val;
+    asm volatile("mrc p15, 0, %0, c14, c0, 0" : "=r"(val));
+    return val;
+}
+
+/* Cores without the generic timer extension, e.g. the Cortex-A9, have
+ * ID_PFR1.GenTimer (bits 19:16) clear. */
+static inline int generic_timer_present(void)
+{
+    uint32_t val;
+    asm volatile("mrc p15, 0, %0, c0, c1, 1" : "=r"(val));
+    return (val >> 16) & 0xf;
+}
@@ -35,3 +35,7 @@ extern uint32_t _boot_pt[BIT(PT_BITS)];
 extern uint64_t _lpae_boot_pgd[BIT(HYP_PGD_BITS)];
 extern uint64_t _lpae_boot_pmd[BIT(HYP_PGD_BITS + HYP_PMD_BITS)];
 
+extern uint32_t _load_pd[BIT(PD_BITS)];
+
+extern uint64_t _lpae_load_pgd[BIT(HYP_PGD_BITS)];
+extern uint64_t _lpae_load_pmd[BIT(HYP_PGD_BITS + HYP_PMD_BITS)];
@@ -25,3 +25,24 @@ static inline void reset_cntvoff(void)
         printf("Not in hyp mode, cannot reset CNTVOFF_EL2\n");
     }
 }
+
+/* Read the physical counter, the ISB keeps it from being read early. */
+static inline uint64_t read_cntpct(void)
+{
+    uint64_t val;
+    asm volatile("isb; mrs %0, cntpct_el0" : "=r"(val) :: "memory");
+    return val;
+}
+
+static inline uint32_t read_cntfrq(void)
+{
+    uint64_t val;
+    asm volatile("mrs %0, cntfrq_el0" : "=r"(val));
+    return val;
+}
+
+/* The generic timer is mandatory in ARMv8-A. */
+static inline int generic_timer_present(void)
+{
+    return 1;
+}
@@ -43,6 +43,8 @@
 #define TCR_SH0_ISH       (3 << 12)
 #define TCR_SHARED        ((3 << 12) | (3 << 28))
 
+#define TCR_EPD1          (1 << 23)
+
 #define TCR_TG0_4K        (0 << 14)
 #define TCR_TG0_64K       (1 << 14)
 #define TCR_TG1_4K        (2 << 30)
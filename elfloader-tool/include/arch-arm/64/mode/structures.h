@@ -21,6 +21,9 @@
 #define PMD_BITS                9
 #define PMD_SIZE_BITS           (PMD_BITS + PMDE_SIZE_BITS)
 
+/* Number of PMDs available to split 1 GiB blocks of the load mapping */
+#define LOAD_PMD_TABLES         4
+
 #define GET_PGD_INDEX(x)        (((x) >> (ARM_2MB_BLOCK_BITS + PMD_BITS + PUD_BITS)) & MASK(PGD_BITS))
 #define GET_PUD_INDEX(x)        (((x) >> (ARM_2MB_BLOCK_BITS + PMD_BITS)) & MASK(PUD_BITS))
 #define GET_PMD_INDEX(x)        (((x) >> (ARM_2MB_BLOCK_BITS)) & MASK(PMD_BITS))
@@ -32,3 +35,7 @@ extern uint64_t _boot_pmd_up[BIT(PMD_BITS)];
 extern uint64_t _boot_pgd_down[BIT(PGD_BITS)];
 extern uint64_t _boot_pud_down[BIT(PUD_BITS)];
 extern uint64_t _boot_pmd_down[BIT(PMD_BITS)];
+
+extern uint64_t _load_pgd[BIT(PGD_BITS)];
+extern uint64_t _load_pud[BIT(PUD_BITS)];
+extern uint64_t _load_pmd[LOAD_PMD_TABLES][BIT(PMD_BITS)];
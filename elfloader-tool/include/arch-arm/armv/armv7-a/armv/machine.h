@@ -11,6 +11,16 @@ static inline void wfi(void)
     asm volatile("wfi" ::: "memory");
 }
 
+static inline void wfe(void)
+{
+    asm volatile("wfe" ::: "memory");
+}
+
+static inline void sev(void)
+{
+    asm volatile("sev" ::: "memory");
+}
+
 static inline void dsb(void)
 {
     asm volatile("dsb" ::: "memory");
@@ -25,6 +25,15 @@ extern void arm_enable_mmu(void);
 extern void arm_enable_hyp_mmu(void);
 
 
+/* Enable/disable the mmu with the 1:1 mapping used while loading images. */
+extern void arm_enable_load_mmu(void);
+extern void arm_disable_load_mmu(void);
+extern void arm_enable_hyp_load_mmu(void);
+extern void arm_disable_hyp_load_mmu(void);
+
+/* Setup the VSpace for loading images, returns 0 on success. */
+int init_load_vspace(void);
+
 /* Setup boot VSpace. */
 void init_boot_vspace(struct image_info *kernel_info);
 void init_hyp_boot_vspace(struct image_info *kernel_info);
@@ -32,9 +41,18 @@ void init_hyp_boot_vspace(struct image_info *kernel_info);
 /* Assembly functions. */
 extern void flush_dcache(void);
 extern void cpu_idle(void);
+extern void arm_disable_dcaches(void);
 
 
 void smp_boot(void);
 
+/* Load images on all cores, see smp_load.c */
+void smp_load_start(int cached);
+void smp_load_stop(void);
+void smp_load_wait(void);
+void smp_load_worker(int cpu);
+void *smp_load_memcpy(void *dest, void const *src, size_t n);
+void *smp_load_memset(void *s, int c, size_t n);
+
 /* Secure monitor call */
 uint32_t smc(uint32_t, uint32_t, uint32_t, uint32_t);
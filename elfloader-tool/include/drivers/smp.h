@@ -13,6 +13,12 @@
 struct elfloader_smp_ops {
     const char *enable_method;
     int (*cpu_on)(struct elfloader_device *smp_dev, struct elfloader_cpu *cpu, void *entry, void *stack);
+    /*
+     * Set if cpu_on() does not pass the entry point and stack in the shared
+     * secondary_data, so the next core can be started before the previous one
+     * is up.
+     */
+    int concurrent;
 };
 
 struct smp_cpu_data {
@@ -22,5 +28,7 @@ struct smp_cpu_data {
 
 extern struct smp_cpu_data secondary_data;
 void secondary_startup(void);
+void secondary_startup_arg(void);
 void smp_register_handler(struct elfloader_device *dev);
 int plat_cpu_on(struct elfloader_cpu *cpu, void *entry, void *stack);
+int plat_cpu_on_concurrent(void);
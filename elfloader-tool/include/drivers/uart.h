@@ -6,12 +6,21 @@
 
 #pragma once
 
+#include <types.h>
 #include <drivers/common.h>
 
 #define dev_get_uart(dev) ((struct elfloader_uart_ops *)(dev->drv->ops))
 
 struct elfloader_uart_ops {
     int (*putc)(struct elfloader_device *dev, unsigned int c);
+    /* Optional, returns non-zero if putc() would not have to wait. */
+    int (*tx_ready)(struct elfloader_device *dev);
+    /*
+     * Optional, waits until the UART takes data and then writes as many of the
+     * 'len' > 0 characters as fit into the transmit FIFO after this one status
+     * check. Returns the number of characters written.
+     */
+    size_t (*write)(struct elfloader_device *dev, char const *buf, size_t len);
 };
 
 volatile void *uart_get_mmio(void);
@@ -7,6 +7,8 @@
 
 #pragma once
 
+#include <autoconf.h>
+#include <elfloader/gen_config.h>
 #include <types.h>
 
 typedef uintptr_t paddr_t;
@@ -17,6 +19,7 @@ typedef uintptr_t vaddr_t;
 #define BIT(x)              (1 << (x))
 #define MASK(n)             (BIT(n) - 1)
 #define MIN(a, b)           (((a) < (b)) ? (a) : (b))
+#define MAX(a, b)           (((a) > (b)) ? (a) : (b))
 #define IS_ALIGNED(n, b)    (!((n) & MASK(b)))
 #define ROUND_UP(n, b)      (((((n) - 1) >> (b)) + 1) << (b))
 #define ROUND_DOWN(n, b) (((n) >> (b)) << (b))
@@ -97,7 +100,43 @@ int load_images(
     void const **chosen_dtb,
     size_t *chosen_dtb_size);
 
+/* Memory map of the platform, see platform_info.h */
+int get_memory_region(unsigned int i, paddr_t *start, paddr_t *end);
+
 /* Platform functions */
 void platform_init(void);
 void init_cpus(void);
 int plat_console_putchar(unsigned int c);
+int plat_console_write(char const *buf, size_t len);
+
+#ifdef CONFIG_ELFLOADER_CONSOLE_BUFFER
+/*
+ * The console output is collected in a RAM buffer and sent to the UART by
+ * console_poll(), which only writes as much as the UART takes without waiting.
+ * console_flush() waits until everything is sent. console_finish() is called
+ * last before jumping to the kernel.
+ */
+void console_poll(void);
+void console_flush(void);
+void console_finish(void);
+#else
+static inline void console_poll(void) {}
+static inline void console_flush(void) {}
+static inline void console_finish(void) {}
+#endif
+
+#ifdef CONFIG_ELFLOADER_CONSOLE_HANDOFF
+/*
+ * Instead of waiting for the UART, console_finish() puts the output that has
+ * not been sent yet into this property of /chosen in the DTB passed to the
+ * kernel. It has a fixed size of one byte more than the buffer and is padded
+ * with NUL characters, so it is always NUL terminated.
+ */
+#define CONSOLE_FDT_PROPERTY    "seL4,elfloader-console"
+#define CONSOLE_FDT_SPACE       (12 + ROUND_UP(CONFIG_ELFLOADER_CONSOLE_BUFFER_SIZE + 1, 2) + \
+                                 sizeof(CONSOLE_FDT_PROPERTY))
+
+/* Add the property to a DTB of 'size' bytes with room for 'space' bytes and
+ * return the new size of the DTB. */
+size_t console_attach_fdt(void *fdt, size_t size, size_t space);
+#endif
@@ -8,3 +8,32 @@
 
 size_t fdt_size(
     void const *fdt);
+
+uint32_t be32_to_le(
+    uint32_t be);
+
+/*
+ * Read the 32-bit property 'prop' of the top level node 'node', e.g. "cpus".
+ *
+ * Returns 0 on success or -1 if there is no such property.
+ */
+int fdt_get_u32(
+    void const *fdt,
+    char const *node,
+    char const *prop,
+    uint32_t *val);
+
+/*
+ * Add the property 'prop' with 'len' zeroed bytes of data to the top level
+ * node 'node' of the DTB at 'fdt', which may grow to 'space' bytes. The DTB
+ * must have its strings block last, as dtc lays it out.
+ *
+ * Returns a pointer to the data of the new property, which is 4 byte aligned,
+ * or NULL if the property could not be added.
+ */
+void *fdt_add_property(
+    void *fdt,
+    size_t space,
+    char const *node,
+    char const *prop,
+    size_t len);
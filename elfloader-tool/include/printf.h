@@ -6,9 +6,43 @@
 
 #pragma once
 
+#include <autoconf.h>
+#include <elfloader/gen_config.h>
+
 #define NULL ((void *)0)
 #define FILE void
 
-int printf(const char *format, ...);
-int sprintf(char *buff, const char *format, ...);
+int printf(const char *format, ...) __attribute__((format(__printf__, 1, 2)));
+int sprintf(char *buff, const char *format, ...) __attribute__((format(__printf__, 2, 3)));
+
+/*
+ * Log levels, selected with ElfloaderLogLevel. Messages above the configured
+ * level are compiled out together with their format strings, the arguments are
+ * still type checked. Errors are printed with plain printf() and an "ERROR: "
+ * prefix at every level.
+ */
+#define LOG_LEVEL_ERROR 0
+#define LOG_LEVEL_INFO  1
+#define LOG_LEVEL_DEBUG 2
+
+#if defined(CONFIG_ELFLOADER_LOG_LEVEL_ERROR)
+#define LOG_LEVEL LOG_LEVEL_ERROR
+#elif defined(CONFIG_ELFLOADER_LOG_LEVEL_INFO)
+#define LOG_LEVEL LOG_LEVEL_INFO
+#else
+#define LOG_LEVEL LOG_LEVEL_DEBUG
+#endif
+
+#define LOG_ENABLED(level) (LOG_LEVEL >= LOG_LEVEL_##level)
+
+#define log_info(...) do { \
+    if (LOG_ENABLED(INFO)) { \
+        printf(__VA_ARGS__); \
+    } \
+} while (0)
 
+#define log_debug(...) do { \
+    if (LOG_ENABLED(DEBUG)) { \
+        printf(__VA_ARGS__); \
+    } \
+} while (0)
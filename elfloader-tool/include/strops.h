@@ -14,4 +14,20 @@ int strncmp(const char *s1, const char *s2, size_t n);
 void *memset(void *s, int c, size_t n);
 void *memmove(void *dest, const void *src, size_t n);
 void *memcpy(void *dest, const void *src, size_t n);
+void *memcpy_misaligned(void *dest, const void *src, size_t n);
 
+/*
+ * Optional architecture support for memset(), see string.c. The block size is
+ * a power of two, arch_zero_blocks() is only called with 's' and 'n' aligned
+ * to it.
+ */
+size_t arch_zero_block_size(void);
+void arch_zero_blocks(void *s, size_t n);
+
+/*
+ * Check memcpy(), memmove() and memset() for a range of alignments and sizes.
+ * Only available with CONFIG_ELFLOADER_STRING_SELF_TEST.
+ *
+ * Returns 0 on success or -1 after printing the first failing case.
+ */
+int string_self_test(void);
@@ -4,9 +4,12 @@
  * SPDX-License-Identifier: GPL-2.0-only
  */
 
+#include <autoconf.h>
+#include <elfloader/gen_config.h>
 #include <types.h>
 #include <elfloader.h>
 #include <mode/structures.h>
+#include <cpuid.h>
 
 #define ARM_VECTOR_TABLE    0xffff0000 // Configured by setting bit 13 in SCTLR
 extern char arm_vector_table[1];
@@ -93,3 +96,111 @@ void init_hyp_boot_vspace(struct image_info *kernel_info)
                                     | BIT(0); /* Valid */
     }
 }
+
+#ifdef CONFIG_ELFLOADER_CACHED_LOAD
+
+/* 1M section of normal WBWA memory */
+static uint32_t load_pd_normal(uint32_t i)
+{
+    return (i << ARM_SECTION_BITS)
+#if CONFIG_MAX_NUM_NODES > 1
+           | BIT(16) /* shareable */
+#endif
+           | BIT(12) /* TEX = 0b001 */
+           | BIT(10) /* kernel-only access */
+           | BIT(3)  /* C */
+           | BIT(2)  /* B */
+           | BIT(1); /* 1M section */
+}
+
+/* 2M block of normal WBWA memory, see the HMAIR0 setup in arm_enable_hyp_load_mmu() */
+static uint64_t load_pmd_normal(uint32_t i)
+{
+    return ((uint64_t)i << ARM_2MB_BLOCK_BITS)
+           | BIT(10)  /* AF - Not always HW managed */
+           | (3 << 8) /* inner shareable */
+           | (1 << 2) /* MAIR index 1, normal memory */
+           | BIT(0);  /* Valid */
+}
+
+/* Short-descriptor version of init_load_vspace(), using 1M sections. */
+static void init_load_pd(void)
+{
+    uint32_t i;
+    unsigned int r;
+    paddr_t start, end;
+
+    for (i = 0; i < BIT(PD_BITS); i++) {
+        _load_pd[i] = (i << ARM_SECTION_BITS)
+                      | BIT(10) /* kernel-only access */
+                      | BIT(4)  /* execute never */
+                      | BIT(2)  /* shared device */
+                      | BIT(1); /* 1M section */
+    }
+
+    for (r = 0; get_memory_region(r, &start, &end) == 0; r++) {
+        for (i = ROUND_UP(start, ARM_SECTION_BITS) >> ARM_SECTION_BITS;
+             i < ROUND_DOWN(end, ARM_SECTION_BITS) >> ARM_SECTION_BITS; i++) {
+            _load_pd[i] = load_pd_normal(i);
+        }
+    }
+
+    /* Elfloader itself, in case its memory region is not section aligned */
+    for (i = (vaddr_t)_text >> ARM_SECTION_BITS; i <= (vaddr_t)_end >> ARM_SECTION_BITS; i++) {
+        _load_pd[i] = load_pd_normal(i);
+    }
+}
+
+/* LPAE version of init_load_vspace() for HYP mode, using 2M blocks. */
+static void init_lpae_load_pgd(void)
+{
+    uint32_t i;
+    unsigned int r;
+    paddr_t start, end;
+
+    for (i = 0; i < BIT(HYP_PGD_BITS); i++) {
+        _lpae_load_pgd[i] = ((uintptr_t)_lpae_load_pmd + (i << PAGE_BITS))
+                            | BIT(1)  /* Page table */
+                            | BIT(0); /* Valid */
+    }
+
+    for (i = 0; i < BIT(HYP_PGD_BITS + HYP_PMD_BITS); i++) {
+        _lpae_load_pmd[i] = ((uint64_t)i << ARM_2MB_BLOCK_BITS)
+                            | ((uint64_t)1 << 54) /* XN */
+                            | BIT(10) /* AF - Not always HW managed */
+                            | BIT(0); /* Valid, MAIR index 0, device memory */
+    }
+
+    for (r = 0; get_memory_region(r, &start, &end) == 0; r++) {
+        for (i = ROUND_UP(start, ARM_2MB_BLOCK_BITS) >> ARM_2MB_BLOCK_BITS;
+             i < ROUND_DOWN(end, ARM_2MB_BLOCK_BITS) >> ARM_2MB_BLOCK_BITS; i++) {
+            _lpae_load_pmd[i] = load_pmd_normal(i);
+        }
+    }
+
+    /* Elfloader itself, in case its memory region is not 2M aligned */
+    for (i = (vaddr_t)_text >> ARM_2MB_BLOCK_BITS; i <= (vaddr_t)_end >> ARM_2MB_BLOCK_BITS; i++) {
+        _lpae_load_pmd[i] = load_pmd_normal(i);
+    }
+}
+
+/*
+ * Create the 1:1 mapping that is used while the images are unpacked. The
+ * memory regions of the platform are mapped as normal cacheable memory, the
+ * rest of the address space as device memory, which also covers the UART.
+ * Memory that does not fill a whole section (or 2M block in HYP mode) is left
+ * as device memory, except for the ELF-loader itself.
+ *
+ * Returns 0, the whole 4 GiB address space is always covered.
+ */
+int init_load_vspace(void)
+{
+    if (is_hyp_mode()) {
+        init_lpae_load_pgd();
+    } else {
+        init_load_pd();
+    }
+    return 0;
+}
+
+#endif /* CONFIG_ELFLOADER_CACHED_LOAD */
@@ -28,6 +28,9 @@ void core_entry(uint32_t sp)
 
     core_up[id] = id;
     dsb();
+#ifdef CONFIG_ELFLOADER_PARALLEL_LOAD
+    smp_load_worker(id);
+#endif
     non_boot_main();
 }
 
@@ -4,6 +4,7 @@
  * SPDX-License-Identifier: GPL-2.0-only
  */
 
+#include <elfloader/gen_config.h>
 #include <elfloader.h>
 #include <types.h>
 #include <mode/structures.h>
@@ -16,6 +17,14 @@ uint32_t _boot_pt[BIT(PT_BITS)] ALIGN(BIT(PT_SIZE_BITS));
 uint64_t _lpae_boot_pgd[BIT(HYP_PGD_BITS)] ALIGN(BIT(HYP_PGD_SIZE_BITS));
 uint64_t _lpae_boot_pmd[BIT(HYP_PGD_BITS + HYP_PMD_BITS)] ALIGN(BIT(HYP_PMD_SIZE_BITS));
 
+#ifdef CONFIG_ELFLOADER_CACHED_LOAD
+/* Paging structures for the 1:1 mapping used while loading the images */
+uint32_t _load_pd[BIT(PD_BITS)] ALIGN(BIT(PD_SIZE_BITS));
+
+uint64_t _lpae_load_pgd[BIT(HYP_PGD_BITS)] ALIGN(BIT(HYP_PGD_SIZE_BITS));
+uint64_t _lpae_load_pmd[BIT(HYP_PGD_BITS + HYP_PMD_BITS)] ALIGN(BIT(HYP_PMD_SIZE_BITS));
+#endif
+
 /*
  * These are helper functions which let the ASM work when we're relocated,
  * and save the ASM from manually having to figure out offsets to access these.
@@ -29,3 +38,15 @@ void *get_lpae_boot_pgd(void)
 {
     return _lpae_boot_pgd;
 }
+
+#ifdef CONFIG_ELFLOADER_CACHED_LOAD
+void *get_load_pd(void)
+{
+    return _load_pd;
+}
+
+void *get_lpae_load_pgd(void)
+{
+    return _lpae_load_pgd;
+}
+#endif
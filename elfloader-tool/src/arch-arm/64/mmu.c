@@ -11,6 +11,7 @@
 #include <mode/structures.h>
 #include <printf.h>
 #include <abort.h>
+#include <cpuid.h>
 
 /*
 * Create the 1:1 elfloader mapping to jump into the kernel after enabling the MMU.
@@ -104,3 +105,142 @@ void init_hyp_boot_vspace(struct image_info *kernel_info)
                           | BIT(0); /* 2M block */
     }
 }
+
+#ifdef CONFIG_ELFLOADER_CACHED_LOAD
+
+static unsigned int num_load_pmds;
+
+/* Attributes for blocks of the load mapping that are not in a memory region */
+static uint64_t load_device_attrs(void)
+{
+    uint64_t attrs = BIT(10)  /* access flag */
+                     | (0 << 2) /* MT_DEVICE_nGnRnE */
+                     | BIT(0);  /* block */
+
+    /* Never execute from device memory, there is only one XN bit in EL2. */
+    attrs |= (uint64_t)1 << 54; /* UXN/XN */
+    if (!is_hyp_mode()) {
+        attrs |= (uint64_t)1 << 53; /* PXN */
+    }
+    return attrs;
+}
+
+/*
+ * Get the PMD for the 1 GiB block at 'pud_index'. If the block is not split
+ * yet, a PMD is taken from the pool and filled with device blocks.
+ */
+static uint64_t *get_load_pmd(word_t pud_index)
+{
+    word_t i;
+    uint64_t *pmd;
+    uint64_t pude = _load_pud[pud_index];
+
+    if (pude & BIT(1)) {
+        /* its a page table already */
+        return (uint64_t *)(uintptr_t)(pude & ~(uint64_t)MASK(PAGE_BITS));
+    }
+
+    if (num_load_pmds >= LOAD_PMD_TABLES) {
+        return NULL;
+    }
+    pmd = _load_pmd[num_load_pmds++];
+
+    for (i = 0; i < BIT(PMD_BITS); i++) {
+        pmd[i] = (((uint64_t)pud_index << ARM_1GB_BLOCK_BITS) + ((uint64_t)i << ARM_2MB_BLOCK_BITS))
+                 | load_device_attrs();
+    }
+    _load_pud[pud_index] = ((uintptr_t)pmd) | BIT(1) | BIT(0); /* its a page table */
+
+    return pmd;
+}
+
+/* Map the 2 MiB block at 'paddr' as normal memory, unless it is already. */
+static int map_load_block(paddr_t paddr, uint64_t attrs)
+{
+    uint64_t *pmd;
+    uint64_t pude = _load_pud[GET_PUD_INDEX(paddr)];
+
+    if (!(pude & BIT(1)) && (pude & (7 << 2)) == (4 << 2)) {
+        /* covered by a 1 GiB block of normal memory */
+        return 0;
+    }
+
+    pmd = get_load_pmd(GET_PUD_INDEX(paddr));
+    if (!pmd) {
+        printf("ERROR: out of PMDs for the load mapping\n");
+        return -1;
+    }
+    pmd[GET_PMD_INDEX(paddr)] = paddr | attrs;
+    return 0;
+}
+
+/*
+ * Create the 1:1 mapping that is used while the images are unpacked. The
+ * memory regions of the platform are mapped as normal cacheable memory, the
+ * rest of the lower 512 GiB is mapped as device memory, which also covers the
+ * UART. 1 GiB blocks are used where possible, a GiB that is only partially
+ * covered by memory is split into 2 MiB blocks. Memory that is not 2 MiB
+ * aligned is left as device memory, except for the ELF-loader itself.
+ *
+ * Returns 0 on success or -1 if the mapping can't be created, the images
+ * must then be loaded with the MMU disabled.
+ */
+int init_load_vspace(void)
+{
+    word_t i;
+    unsigned int r;
+    paddr_t start, end;
+    uint64_t normal_attrs = BIT(10)  /* access flag */
+                            | (3 << 8) /* inner shareable */
+                            | (4 << 2) /* MT_NORMAL memory */
+                            | BIT(0);  /* block */
+
+    num_load_pmds = 0;
+
+    _load_pgd[0] = ((uintptr_t)_load_pud) | BIT(1) | BIT(0); /* its a page table */
+    for (i = 1; i < BIT(PGD_BITS); i++) {
+        _load_pgd[i] = 0;
+    }
+
+    for (i = 0; i < BIT(PUD_BITS); i++) {
+        _load_pud[i] = ((uint64_t)i << ARM_1GB_BLOCK_BITS) | load_device_attrs();
+    }
+
+    for (r = 0; get_memory_region(r, &start, &end) == 0; r++) {
+        if (GET_PGD_INDEX(end - 1) != 0) {
+            printf("ERROR: memory region %u is above 512 GiB, can't create load mapping\n", r);
+            return -1;
+        }
+
+        start = ROUND_UP(start, ARM_2MB_BLOCK_BITS);
+        end = ROUND_DOWN(end, ARM_2MB_BLOCK_BITS);
+
+        while (start < end) {
+            if (IS_ALIGNED(start, ARM_1GB_BLOCK_BITS) && end - start >= BIT(ARM_1GB_BLOCK_BITS)) {
+                _load_pud[GET_PUD_INDEX(start)] = start | normal_attrs;
+                start += BIT(ARM_1GB_BLOCK_BITS);
+                continue;
+            }
+            if (map_load_block(start, normal_attrs)) {
+                return -1;
+            }
+            start += BIT(ARM_2MB_BLOCK_BITS);
+        }
+    }
+
+    /*
+     * Device memory is never executable, so make sure the ELF-loader itself
+     * is mapped as normal memory, even if the memory region it is in is not
+     * 2 MiB aligned. init_downpages() does the same.
+     */
+    for (start = ROUND_DOWN((paddr_t)_text, ARM_2MB_BLOCK_BITS); start < (paddr_t)_end;
+         start += BIT(ARM_2MB_BLOCK_BITS)) {
+        if (map_load_block(start, normal_attrs)) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+#endif /* CONFIG_ELFLOADER_CACHED_LOAD */
@@ -0,0 +1,77 @@
+/*
+ * Copyright 2020, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ */
+
+#include <autoconf.h>
+#include <elfloader/gen_config.h>
+
+#ifdef CONFIG_HASH_SHA
+#include <types.h>
+#include <elfloader_common.h>
+#include <cpuid.h>
+#include <armv/machine.h>
+
+#include "../../crypt_sha256.h"
+
+/* ID_AA64ISAR0_EL1.SHA2, 1 if the SHA256 instructions are implemented */
+#define ID_AA64ISAR0_SHA2_SHIFT 12
+#define ID_AA64ISAR0_SHA2_MASK  0xf
+
+/* Trap bits for FP/SIMD instructions */
+#define CPACR_EL1_FPEN          (3 << 20)
+#define CPTR_EL2_TFP            BIT(10)
+
+enum sha256_ce_state {
+    SHA256_CE_UNKNOWN = 0,
+    SHA256_CE_AVAILABLE,
+    SHA256_CE_UNAVAILABLE,
+};
+
+static enum sha256_ce_state sha256_ce;
+
+extern void sha256_ce_transform(uint32_t h[8], const uint8_t *buf,
+                                unsigned long n, uint8_t *copy);
+
+/*
+ * Use the SHA256 instructions of the Cryptography Extension if the CPU has
+ * them. The ELF-loader doesn't use FP/SIMD otherwise, so its traps are only
+ * disabled while the blocks are hashed.
+ */
+unsigned long arch_sha256_blocks(uint32_t h[8], const uint8_t *buf,
+                                 unsigned long n, uint8_t *copy)
+{
+    word_t reg;
+
+    if (sha256_ce == SHA256_CE_UNKNOWN) {
+        MRS("id_aa64isar0_el1", reg);
+        if (((reg >> ID_AA64ISAR0_SHA2_SHIFT) & ID_AA64ISAR0_SHA2_MASK) != 0) {
+            sha256_ce = SHA256_CE_AVAILABLE;
+        } else {
+            sha256_ce = SHA256_CE_UNAVAILABLE;
+        }
+    }
+    if (sha256_ce != SHA256_CE_AVAILABLE) {
+        return 0;
+    }
+
+    if (is_hyp_mode()) {
+        MRS("cptr_el2", reg);
+        MSR("cptr_el2", reg & ~CPTR_EL2_TFP);
+        isb();
+        sha256_ce_transform(h, buf, n, copy);
+        MSR("cptr_el2", reg);
+    } else {
+        MRS("cpacr_el1", reg);
+        MSR("cpacr_el1", reg | CPACR_EL1_FPEN);
+        isb();
+        sha256_ce_transform(h, buf, n, copy);
+        MSR("cpacr_el1", reg);
+    }
+    isb();
+
+    return n;
+}
+
+#endif /* CONFIG_HASH_SHA */
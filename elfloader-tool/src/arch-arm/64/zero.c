@@ -0,0 +1,51 @@
+/*
+ * Copyright 2020, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ */
+
+#include <types.h>
+#include <strops.h>
+#include <cpuid.h>
+
+#define DCZID_BS_MASK   0xf
+#define DCZID_DZP       0x10ul
+
+#define SCTLR_M         0x1ul
+#define SCTLR_C         0x4ul
+
+/*
+ * DC ZVA zeroes a whole block of DCZID_EL0.BS words. It faults on Device memory,
+ * which all memory is while the MMU is off, so it is only used when the MMU and
+ * data caches are on. DCZID_EL0.DZP is also set if a hypervisor traps DC ZVA.
+ */
+size_t arch_zero_block_size(void)
+{
+    word_t dczid, sctlr;
+
+    asm volatile("mrs %0, dczid_el0" : "=r"(dczid));
+    if (dczid & DCZID_DZP) {
+        return 0;
+    }
+
+    if (is_hyp_mode()) {
+        asm volatile("mrs %0, sctlr_el2" : "=r"(sctlr));
+    } else {
+        asm volatile("mrs %0, sctlr_el1" : "=r"(sctlr));
+    }
+    if ((sctlr & (SCTLR_M | SCTLR_C)) != (SCTLR_M | SCTLR_C)) {
+        return 0;
+    }
+
+    return 4ul << (dczid & DCZID_BS_MASK);
+}
+
+void arch_zero_blocks(void *s, size_t n)
+{
+    size_t block = arch_zero_block_size();
+    uintptr_t p = (uintptr_t)s;
+
+    for (; n > 0; n -= block, p += block) {
+        asm volatile("dc zva, %0" :: "r"(p) : "memory");
+    }
+}
@@ -30,6 +30,9 @@ void core_entry(uint64_t sp)
 
     core_up[id] = id;
     dmb();
+#ifdef CONFIG_ELFLOADER_PARALLEL_LOAD
+    smp_load_worker(id);
+#endif
     non_boot_main();
 }
 
@@ -0,0 +1,32 @@
+/*
+ * Copyright 2020, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ */
+
+#include <autoconf.h>
+#include <elfloader/gen_config.h>
+
+#ifdef CONFIG_ELFLOADER_BOOT_TIME
+#include <types.h>
+#include <elfloader_common.h>
+#include <mode/arm_generic_timer.h>
+
+#include "../boot_time.h"
+
+/*
+ * The boot phases are timed with the physical count of the generic timer. It
+ * usually starts at reset, so the first record also shows how long the boot
+ * stages before the ELF-loader took.
+ */
+uint64_t arch_boot_time_counter(void)
+{
+    return generic_timer_present() ? read_cntpct() : 0;
+}
+
+uint64_t arch_boot_time_frequency(UNUSED void const *fdt)
+{
+    return generic_timer_present() ? read_cntfrq() : 0;
+}
+
+#endif /* CONFIG_ELFLOADER_BOOT_TIME */
@@ -14,6 +14,14 @@
 #include <printf.h>
 #include <types.h>
 
+#if CONFIG_MAX_NUM_NODES > 1
+/*
+ * Every core gets its own entry point and stack, passed as the context ID of
+ * CPU_ON, so the cores can be started without waiting for each other.
+ */
+static struct smp_cpu_data psci_cpu_data[CONFIG_MAX_NUM_NODES];
+#endif
+
 static int smp_psci_cpu_on(UNUSED struct elfloader_device *dev,
                            UNUSED struct elfloader_cpu *cpu, UNUSED void *entry, UNUSED void *stack)
 {
@@ -22,12 +30,19 @@ static int smp_psci_cpu_on(UNUSED struct elfloader_device *dev,
         printf("HVC is not supported for PSCI!\n");
         return -1;
     }
-    secondary_data.entry = entry;
-    secondary_data.stack = stack;
+    /* The logical ID of the core, as worked out by core_entry() */
+    unsigned long id = ((unsigned long)stack - (unsigned long)&core_stacks[0][0]) / STACK_SIZE;
+    if (id >= CONFIG_MAX_NUM_NODES) {
+        return -1;
+    }
+    struct smp_cpu_data *data = &psci_cpu_data[id];
+    data->entry = entry;
+    data->stack = stack;
     dmb();
-    int ret = psci_cpu_on(cpu->cpu_id, (unsigned long)&secondary_startup, 0);
+    int ret = psci_cpu_on(cpu->cpu_id, (unsigned long)&secondary_startup_arg,
+                          (unsigned long)data);
     if (ret != PSCI_SUCCESS) {
-        printf("Failed to bring up core 0x%x with error %d\n", cpu->cpu_id, ret);
+        printf("Failed to bring up core 0x%"PRIx_word" with error %d\n", cpu->cpu_id, ret);
         return -1;
     }
 
@@ -54,6 +69,7 @@ static const struct dtb_match_table smp_psci_matches[] = {
 static const struct elfloader_smp_ops smp_psci_ops = {
     .enable_method = "psci",
     .cpu_on = &smp_psci_cpu_on,
+    .concurrent = 1,
 };
 
 static const struct elfloader_driver smp_psci = {
@@ -17,12 +17,11 @@
 #include <elfloader.h>
 #include <armv/smp.h>
 #include <armv/machine.h>
+#include <mode/arm_generic_timer.h>
 
 #if CONFIG_MAX_NUM_NODES > 1
 static volatile int non_boot_lock = 0;
 
-void arm_disable_dcaches(void);
-
 extern void const *dtb;
 extern uint32_t dtb_size;
 
@@ -32,19 +31,20 @@ void non_boot_main(void)
 #ifndef CONFIG_ARCH_AARCH64
     arm_disable_dcaches();
 #endif
-    /* Spin until the first CPU has finished initialisation. */
-    while (!non_boot_lock) {
-#ifndef CONFIG_ARCH_AARCH64
-        cpu_idle();
-#endif
-    }
-
-    /* Do any driver specific non_boot core init */
+    /* Do any driver specific non_boot core init. If the cores are started
+     * early, this runs while the first CPU is still loading the images. */
     if (initialise_devices_non_boot()) {
         printf("ERROR: Did not successfully return from initialise_devices_non_boot()\n");
         abort();
     }
 
+    /* Wait until the first CPU has finished initialisation. smp_boot() sends
+     * an event after setting the lock, so the core can sleep in the meantime
+     * instead of competing for the memory bus. */
+    while (!non_boot_lock) {
+        wfe();
+    }
+
 #ifndef CONFIG_ARM_HYPERVISOR_SUPPORT
     if (is_hyp_mode()) {
         extern void leave_hyp(void);
@@ -66,6 +66,41 @@ void non_boot_main(void)
     abort();
 }
 
+/* How long init_cpus() waits for the secondary cores to come up */
+#define CPU_UP_TIMEOUT_MS   1000
+
+/*
+ * Returns the counter value at which waiting for a core is given up, or 0 if
+ * there is no generic timer to measure the timeout.
+ */
+static uint64_t cpu_up_deadline(void)
+{
+    if (!generic_timer_present() || read_cntfrq() == 0) {
+        return 0;
+    }
+    return read_cntpct() + (uint64_t)read_cntfrq() * CPU_UP_TIMEOUT_MS / 1000;
+}
+
+/*
+ * Wait until the cores with the logical IDs 'first' to 'last' - 1 are up or the
+ * deadline has passed. Returns the number of cores that are not up.
+ */
+static int wait_for_cores(int first, int last, uint64_t deadline)
+{
+    for (;;) {
+        int pending = 0;
+        for (int id = first; id < last; id++) {
+            if (!is_core_up(id)) {
+                pending++;
+            }
+        }
+        if (pending == 0 || (deadline && read_cntpct() >= deadline)) {
+            return pending;
+        }
+        console_poll();
+    }
+}
+
 /* TODO: convert imx7 to driver model and remove WEAK */
 WEAK void init_cpus(void)
 {
@@ -84,11 +119,11 @@ WEAK void init_cpus(void)
     }
 
     if (booting_cpu_index == -1) {
-        printf("Could not find cpu entry for boot cpu (mpidr=0x%x)\n", mpidr);
+        printf("ERROR: Could not find cpu entry for boot cpu (mpidr=0x%"PRIx_word")\n", mpidr);
         abort();
     }
 
-    printf("Boot cpu id = 0x%x, index=%d\n", mpidr, booting_cpu_index);
+    log_debug("Boot cpu id = 0x%"PRIx_word", index=%d\n", mpidr, booting_cpu_index);
     /*
      * We want to boot CPUs in the same cluster before we boot CPUs in another cluster.
      * This is important on systems like TX2, where the system boots on the A57 cluster,
@@ -97,8 +132,16 @@ WEAK void init_cpus(void)
      * There are a couple of assumptions made here:
      *  1. The elfloader_cpus array is ordered based on the cpuid field (guaranteed by hardware_gen).
      *  2. The CPU we boot on is the first CPU in a cluster (not necessarily the first cluster).
+     *
+     * If the SMP driver passes each core its own entry data, all cores are
+     * started back to back and then waited for together. Otherwise a core has
+     * to be up before the shared secondary_data can be reused for the next one.
      */
     int start_index = booting_cpu_index;
+    int concurrent = plat_cpu_on_concurrent();
+    word_t cpu_ids[CONFIG_MAX_NUM_NODES];
+    int started[CONFIG_MAX_NUM_NODES];
+    int failed = 0;
 
     int num_cpus = 1;
     for (i = start_index + 1; num_cpus < CONFIG_MAX_NUM_NODES && i != start_index; i++) {
@@ -110,15 +153,38 @@ WEAK void init_cpus(void)
             i = -1;
             continue;
         }
+        cpu_ids[num_cpus] = elfloader_cpus[i].cpu_id;
         int ret = plat_cpu_on(&elfloader_cpus[i], core_entry, &core_stacks[num_cpus][0]);
+        started[num_cpus] = (ret == 0);
         if (ret != 0) {
-            printf("Failed to boot cpu 0x%x: %d\n", elfloader_cpus[i].cpu_id, ret);
-            abort();
+            printf("ERROR: Failed to boot cpu 0x%"PRIx_word" (logical id %d): %d\n",
+                   cpu_ids[num_cpus], num_cpus, ret);
+            failed++;
         }
-
-        while (!is_core_up(num_cpus));
-        printf("Core %d is up with logic id %d\n", elfloader_cpus[i].cpu_id, num_cpus);
         num_cpus++;
+        if (ret == 0 && !concurrent &&
+            wait_for_cores(num_cpus - 1, num_cpus, cpu_up_deadline()) != 0) {
+            /* The core may still read secondary_data, don't start any more. */
+            break;
+        }
+    }
+
+    wait_for_cores(1, num_cpus, cpu_up_deadline());
+    for (int id = 1; id < num_cpus; id++) {
+        if (!started[id]) {
+            continue;
+        }
+        if (!is_core_up(id)) {
+            printf("ERROR: cpu 0x%"PRIx_word" (logical id %d) did not come up within %d ms\n",
+                   cpu_ids[id], id, CPU_UP_TIMEOUT_MS);
+            failed++;
+            continue;
+        }
+        log_debug("Core %"PRIu_word" is up with logic id %d\n", cpu_ids[id], id);
+    }
+    if (failed) {
+        printf("ERROR: %d secondary cores failed to start\n", failed);
+        abort();
     }
 
 #ifdef CONFIG_ARCH_AARCH64
@@ -132,7 +198,13 @@ void smp_boot(void)
 #ifndef CONFIG_ARCH_AARCH64
     arm_disable_dcaches();
 #endif
+#ifdef CONFIG_IMAGE_EFI
+    /* The ELF-loader may have relocated itself, so the cores are only
+     * started now. Otherwise main() has started them already. */
     init_cpus();
+#endif
     non_boot_lock = 1;
+    dsb();
+    sev();
 }
 #endif /* CONFIG_MAX_NUM_NODES */
@@ -0,0 +1,235 @@
+/*
+ * Copyright 2020, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ */
+
+#include <autoconf.h>
+#include <elfloader/gen_config.h>
+
+#ifdef CONFIG_ELFLOADER_PARALLEL_LOAD
+#include <types.h>
+#include <strops.h>
+#include <printf.h>
+#include <cpuid.h>
+#include <elfloader.h>
+#include <armv/machine.h>
+#include <armv/smp.h>
+
+/*
+ * The secondary cores are started before the images are loaded and help
+ * copying and zeroing the segments. Every copy or zero operation is a job that
+ * is split into page aligned slices, one for each core. The boot core posts a
+ * job by bumping load_job_id and waits until all cores have acknowledged it in
+ * load_cpu.
+ *
+ * If ElfloaderCachedLoad is set, all cores run with the load mapping and caches
+ * enabled while they work on jobs, so the job data is coherent. The cores only
+ * change their cache state at points where nobody else is communicating with
+ * them through the caches.
+ */
+
+/* Jobs smaller than this are done by the boot core alone */
+#define LOAD_JOB_MIN_SIZE   BIT(16)
+
+enum load_job_type {
+    LOAD_JOB_COPY,
+    LOAD_JOB_ZERO,
+    LOAD_JOB_EXIT,
+};
+
+enum load_state {
+    LOAD_STATE_WAIT = 0,
+    LOAD_STATE_UNCACHED,
+    LOAD_STATE_CACHED,
+};
+
+struct load_job {
+    enum load_job_type type;
+    void *dest;
+    void const *src;
+    size_t size;
+};
+
+/* Set with caches disabled everywhere, before any core enables them */
+static volatile enum load_state load_state;
+static int load_cpus;
+
+static struct load_job load_job;
+static volatile int load_job_id;
+
+/*
+ * Written only by the secondary core that owns them: 'job_done' while it works
+ * on jobs, possibly with its caches enabled, and 'parked' after it has disabled
+ * its caches again. Each core has its own cache lines, which must not be written
+ * by anything else, otherwise a write back of such a line could clobber a flag.
+ */
+struct load_cpu {
+    volatile int job_done;
+    volatile int parked;
+} ALIGN(64);
+static struct load_cpu load_cpu[CONFIG_MAX_NUM_NODES];
+
+static void load_job_slice(struct load_job const *job, int cpu)
+{
+    uintptr_t start = (uintptr_t)job->dest;
+    uintptr_t end = start + job->size;
+    size_t chunk = job->size / load_cpus;
+    uintptr_t first = start;
+    uintptr_t last = end;
+
+    if (cpu != 0) {
+        first = ROUND_UP(start + cpu * chunk, PAGE_BITS);
+    }
+    if (cpu != load_cpus - 1) {
+        last = ROUND_UP(start + (cpu + 1) * chunk, PAGE_BITS);
+    }
+    if (last > end) {
+        last = end;
+    }
+    if (first >= last) {
+        return;
+    }
+
+    if (job->type == LOAD_JOB_COPY) {
+        memcpy((void *)first, (char const *)job->src + (first - start), last - first);
+    } else {
+        memset((void *)first, 0, last - first);
+    }
+}
+
+static void load_job_run(enum load_job_type type, void *dest, void const *src, size_t size)
+{
+    struct load_job job = {
+        .type = type,
+        .dest = dest,
+        .src = src,
+        .size = size,
+    };
+    int id;
+
+    if (load_cpus < 2 || size < LOAD_JOB_MIN_SIZE) {
+        if (type == LOAD_JOB_COPY) {
+            memcpy(dest, src, size);
+        } else {
+            memset(dest, 0, size);
+        }
+        return;
+    }
+
+    load_job = job;
+    dmb();
+    id = load_job_id + 1;
+    load_job_id = id;
+    dsb();
+
+    load_job_slice(&job, 0);
+
+    for (int i = 1; i < load_cpus; i++) {
+        while (load_cpu[i].job_done != id);
+    }
+    dmb();
+}
+
+void *smp_load_memcpy(void *dest, void const *src, size_t n)
+{
+    load_job_run(LOAD_JOB_COPY, dest, src, n);
+    return dest;
+}
+
+void *smp_load_memset(void *s, int c, size_t n)
+{
+    if (c != 0) {
+        return memset(s, c, n);
+    }
+    load_job_run(LOAD_JOB_ZERO, s, NULL, n);
+    return s;
+}
+
+/*
+ * Hand the images to the secondary cores started by main(), they wait in
+ * smp_load_worker() until the boot core has decided whether the load mapping
+ * is used.
+ */
+void smp_load_start(int cached)
+{
+    load_cpus = 1;
+    while (load_cpus < CONFIG_MAX_NUM_NODES && is_core_up(load_cpus)) {
+        load_cpus++;
+    }
+    log_info("Loading images on %d cores\n", load_cpus);
+
+    dsb();
+    load_state = cached ? LOAD_STATE_CACHED : LOAD_STATE_UNCACHED;
+    dsb();
+}
+
+/*
+ * Tell the secondary cores that all images are loaded. This must be called
+ * before the boot core disables its caches.
+ */
+void smp_load_stop(void)
+{
+    if (load_cpus < 2) {
+        return;
+    }
+
+    load_job.type = LOAD_JOB_EXIT;
+    dmb();
+    load_job_id = load_job_id + 1;
+    dsb();
+}
+
+/*
+ * Wait until all secondary cores have cleaned their caches and are parked.
+ * This must be called right after the caches of the boot core are disabled,
+ * before it writes anything else to memory.
+ */
+void smp_load_wait(void)
+{
+    for (int i = 1; i < load_cpus; i++) {
+        while (!load_cpu[i].parked);
+    }
+    dmb();
+}
+
+/* Entry point for the secondary cores while images are loaded. */
+void smp_load_worker(int cpu)
+{
+    int id = 0;
+
+    while (load_state == LOAD_STATE_WAIT);
+
+    if (load_state == LOAD_STATE_CACHED) {
+        if (is_hyp_mode()) {
+            arm_enable_hyp_load_mmu();
+        } else {
+            arm_enable_load_mmu();
+        }
+    }
+
+    for (;;) {
+        while (load_job_id == id);
+        dmb();
+        id = load_job_id;
+        if (load_job.type == LOAD_JOB_EXIT) {
+            break;
+        }
+        load_job_slice(&load_job, cpu);
+        dmb();
+        load_cpu[cpu].job_done = id;
+    }
+
+    if (load_state == LOAD_STATE_CACHED) {
+        if (is_hyp_mode()) {
+            arm_disable_hyp_load_mmu();
+        } else {
+            arm_disable_load_mmu();
+        }
+    }
+
+    load_cpu[cpu].parked = 1;
+    dsb();
+}
+
+#endif /* CONFIG_ELFLOADER_PARALLEL_LOAD */
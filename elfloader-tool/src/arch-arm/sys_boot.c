@@ -19,6 +19,8 @@
 #include <binaries/efi/efi.h>
 #include <elfloader.h>
 
+#include "../boot_time.h"
+
 /* 0xd00dfeed in big endian */
 #define DTB_MAGIC (0xedfe0dd0)
 
@@ -38,6 +40,40 @@ size_t dtb_size;
 extern void finish_relocation(int offset, void *_dynamic, unsigned int total_offset);
 void continue_boot(int was_relocated);
 
+#ifdef CONFIG_ELFLOADER_CACHED_LOAD
+/*
+ * Unpacking the images with the MMU and caches disabled is slow, use a
+ * temporary 1:1 mapping with caches enabled instead. Returns 0 if the mapping
+ * could not be set up, the images are loaded uncached then.
+ */
+static int init_load_mmu(void)
+{
+    if (init_load_vspace() != 0) {
+        log_info("Loading images with caches disabled\n");
+        return 0;
+    }
+    return 1;
+}
+
+static void enable_load_mmu(void)
+{
+    if (is_hyp_mode()) {
+        arm_enable_hyp_load_mmu();
+    } else {
+        arm_enable_load_mmu();
+    }
+}
+
+static void disable_load_mmu(void)
+{
+    if (is_hyp_mode()) {
+        arm_disable_hyp_load_mmu();
+    } else {
+        arm_disable_load_mmu();
+    }
+}
+#endif /* CONFIG_ELFLOADER_CACHED_LOAD */
+
 /*
  * Make sure the ELF loader is below the kernel's first virtual address
  * so that when we enable the MMU we can keep executing.
@@ -79,8 +115,8 @@ void relocate_below_kernel(void)
      */
     uintptr_t new_base = kernel_info.virt_region_start - (ROUND_UP(size, MAX_ALIGN_BITS));
     uint32_t offset = start - new_base;
-    printf("relocating from %p-%p to %p-%p... size=0x%x (padded size = 0x%x)\n", start, end, new_base, new_base + size,
-           size, ROUND_UP(size, MAX_ALIGN_BITS));
+    log_debug("relocating from %p-%p to %p-%p... size=0x%x (padded size = 0x%x)\n", start, end, new_base, new_base + size,
+              size, ROUND_UP(size, MAX_ALIGN_BITS));
 
     memmove((void *)new_base, (void *)start, size);
 
@@ -103,6 +139,8 @@ void main(UNUSED void *arg)
 {
     void *bootloader_dtb = NULL;
 
+    boot_time_mark(BOOT_TIME_START, 0);
+
     /* initialize platform to a state where we can print to a UART */
     if (initialise_devices()) {
         printf("ERROR: Did not successfully return from initialise_devices()\n");
@@ -110,11 +148,14 @@ void main(UNUSED void *arg)
     }
 
     platform_init();
+    boot_time_mark(BOOT_TIME_DEVICES, 0);
 
     /* Print welcome message. */
-    printf("\nELF-loader started on ");
-    print_cpuid();
-    printf("  paddr=[%p..%p]\n", _text, (uintptr_t)_end - 1);
+    if (LOG_ENABLED(INFO)) {
+        printf("\nELF-loader started on ");
+        print_cpuid();
+    }
+    log_debug("  paddr=[%p..%p]\n", _text, (void *)((uintptr_t)_end - 1));
 
 #if defined(CONFIG_IMAGE_UIMAGE)
 
@@ -137,15 +178,62 @@ void main(UNUSED void *arg)
 #endif
 
     if (bootloader_dtb) {
-        printf("  dtb=%p\n", bootloader_dtb);
+        log_debug("  dtb=%p\n", bootloader_dtb);
     } else {
-        printf("No DTB passed in from boot loader.\n");
+        log_info("No DTB passed in from boot loader.\n");
     }
 
+#if CONFIG_MAX_NUM_NODES > 1 && !defined(CONFIG_IMAGE_EFI)
+    /*
+     * Power up the secondary cores now, so their start up and device
+     * initialisation overlaps with loading the images. They wait in
+     * non_boot_main() until smp_boot() releases them, or help loading the
+     * images first with ElfloaderParallelLoad. With EFI the ELF-loader may
+     * still relocate itself, smp_boot() starts the cores then.
+     */
+#ifndef CONFIG_ARCH_AARCH64
+    arm_disable_dcaches();
+#endif
+    init_cpus();
+    boot_time_mark(BOOT_TIME_SMP, 0);
+#endif
+
     /* Unpack ELF images into memory. */
+#ifdef CONFIG_ELFLOADER_CACHED_LOAD
+    int load_mmu = init_load_mmu();
+#else
+    UNUSED int load_mmu = 0;
+#endif
+#ifdef CONFIG_ELFLOADER_PARALLEL_LOAD
+    /* Let the secondary cores help loading the images. */
+    smp_load_start(load_mmu);
+#endif
+#ifdef CONFIG_ELFLOADER_CACHED_LOAD
+    if (load_mmu) {
+        enable_load_mmu();
+    }
+#endif
     unsigned int num_apps = 0;
     int ret = load_images(&kernel_info, &user_info, 1, &num_apps,
                           bootloader_dtb, &dtb, &dtb_size);
+#ifdef CONFIG_ELFLOADER_PARALLEL_LOAD
+    smp_load_stop();
+#endif
+#ifdef CONFIG_ELFLOADER_CACHED_LOAD
+    if (load_mmu) {
+        disable_load_mmu();
+    }
+#endif
+#ifdef CONFIG_ELFLOADER_PARALLEL_LOAD
+    /* Nothing may be written with the caches disabled before the secondary
+     * cores have cleaned theirs. */
+    smp_load_wait();
+#endif
+#ifdef CONFIG_ELFLOADER_CACHED_LOAD
+    if (load_mmu) {
+        boot_time_mark(BOOT_TIME_CACHES, 0);
+    }
+#endif
     if (0 != ret) {
         printf("ERROR: image loading failed\n");
         abort();
@@ -171,7 +259,7 @@ void main(UNUSED void *arg)
 void continue_boot(int was_relocated)
 {
     if (was_relocated) {
-        printf("ELF loader relocated, continuing boot...\n");
+        log_info("ELF loader relocated, continuing boot...\n");
     }
 
     /*
@@ -183,6 +271,7 @@ void continue_boot(int was_relocated)
             printf("ERROR: Did not successfully return from initialise_devices()\n");
             abort();
         }
+        boot_time_mark(BOOT_TIME_DEVICES, 0);
     }
 
 #if (defined(CONFIG_ARCH_ARM_V7A) || defined(CONFIG_ARCH_ARM_V8A)) && !defined(CONFIG_ARM_HYPERVISOR_SUPPORT)
@@ -196,6 +285,7 @@ void continue_boot(int was_relocated)
 #ifdef CONFIG_ARCH_AARCH64
         extern void disable_caches_hyp();
         disable_caches_hyp();
+        boot_time_mark(BOOT_TIME_CACHES, 0);
 #endif
         init_hyp_boot_vspace(&kernel_info);
     } else {
@@ -203,16 +293,31 @@ void continue_boot(int was_relocated)
          * just in case the kernel does not support hyp mode. */
         init_boot_vspace(&kernel_info);
     }
+    boot_time_mark(BOOT_TIME_PAGE_TABLES, 0);
 
 #if CONFIG_MAX_NUM_NODES > 1
     smp_boot();
+    boot_time_mark(BOOT_TIME_SMP, 0);
 #endif /* CONFIG_MAX_NUM_NODES */
 
+#ifdef CONFIG_ELFLOADER_BOOT_TIME
+    /* Only the DTB copy gets the kernel entry record, the boot page tables
+     * don't map it. Enabling the MMU also cleans the data cache, which is not
+     * covered by the records. */
+    boot_time_print();
+#endif
+    boot_time_mark(BOOT_TIME_KERNEL_ENTRY, 0);
+
+    if (is_hyp_mode()) {
+        log_info("Enabling hypervisor MMU and jumping to entry point...\n\n");
+    } else {
+        log_info("Enabling MMU and jumping to entry point...\n\n");
+    }
+    /* The UART is not mapped once the MMU is enabled. */
+    console_finish();
     if (is_hyp_mode()) {
-        printf("Enabling hypervisor MMU and jumping to entry point...\n\n");
         arm_enable_hyp_mmu();
     } else {
-        printf("Enabling MMU and jumping to entry point...\n\n");
         arm_enable_mmu();
     }
     /* Enter kernel. The UART is no longer accessible here. */
@@ -15,6 +15,8 @@
 #include <cpio/cpio.h>
 #include <sbi.h>
 
+#include "../boot_time.h"
+
 #define PT_LEVEL_1 1
 #define PT_LEVEL_2 2
 
@@ -146,7 +148,7 @@ static void set_and_wait_for_ready(int hart_id, int core_id)
 {
     /* Acquire lock to update core ready array */
     while (__atomic_exchange_n(&mutex, 1, __ATOMIC_ACQUIRE) != 0);
-    printf("Hart ID %d core ID %d\n", hart_id, core_id);
+    log_debug("Hart ID %d core ID %d\n", hart_id, core_id);
     core_ready[core_id] = 1;
     __atomic_store_n(&mutex, 0, __ATOMIC_RELEASE);
 
@@ -203,10 +205,11 @@ static int run_elfloader(UNUSED int hart_id, void *bootloader_dtb)
         printf("ERROR: could not map kernel window, code %d\n", ret);
         return -1;
     }
+    boot_time_mark(BOOT_TIME_PAGE_TABLES, 0);
 
 #if CONFIG_MAX_NUM_NODES > 1
     while (__atomic_exchange_n(&mutex, 1, __ATOMIC_ACQUIRE) != 0);
-    printf("Main entry hart_id:%d\n", hart_id);
+    log_debug("Main entry hart_id:%d\n", hart_id);
     __atomic_store_n(&mutex, 0, __ATOMIC_RELEASE);
 
     /* Unleash secondary cores */
@@ -221,12 +224,18 @@ static int run_elfloader(UNUSED int hart_id, void *bootloader_dtb)
     }
 
     set_and_wait_for_ready(hart_id, 0);
+    boot_time_mark(BOOT_TIME_SMP, 0);
+#endif
+
+#ifdef CONFIG_ELFLOADER_BOOT_TIME
+    boot_time_print();
 #endif
+    boot_time_mark(BOOT_TIME_KERNEL_ENTRY, 0);
 
-    printf("Enabling MMU and paging\n");
+    log_info("Enabling MMU and paging\n");
     enable_virtual_memory();
 
-    printf("Jumping to kernel-image entry point...\n\n");
+    log_info("Jumping to kernel-image entry point...\n\n");
     ((init_riscv_kernel_t)kernel_info.virt_entry)(user_info.phys_region_start,
                                                   user_info.phys_region_end,
                                                   user_info.phys_virt_offset,
@@ -248,7 +257,7 @@ void secondary_entry(int hart_id, int core_id)
     while (__atomic_load_n(&secondary_go, __ATOMIC_ACQUIRE) == 0) ;
 
     while (__atomic_exchange_n(&mutex, 1, __ATOMIC_ACQUIRE) != 0);
-    printf("Secondary entry hart_id:%d core_id:%d\n", hart_id, core_id);
+    log_debug("Secondary entry hart_id:%d core_id:%d\n", hart_id, core_id);
     __atomic_store_n(&mutex, 0, __ATOMIC_RELEASE);
 
     set_and_wait_for_ready(hart_id, core_id);
@@ -273,11 +282,13 @@ void secondary_entry(int hart_id, int core_id)
 
 void main(int hart_id, void *bootloader_dtb)
 {
+    boot_time_mark(BOOT_TIME_START, 0);
+
     /* Printing uses SBI, so there is no need to initialize any UART. */
-    printf("ELF-loader started on (HART %d) (NODES %d)\n",
-           hart_id, CONFIG_MAX_NUM_NODES);
+    log_info("ELF-loader started on (HART %d) (NODES %d)\n",
+             hart_id, CONFIG_MAX_NUM_NODES);
 
-    printf("  paddr=[%p..%p]\n", _text, (uintptr_t)_end - 1);
+    log_debug("  paddr=[%p..%p]\n", _text, (void *)((uintptr_t)_end - 1));
 
     /* Run the actual ELF loader, this is not expected to return unless there
      * was an error.
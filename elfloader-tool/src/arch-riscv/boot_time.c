@@ -0,0 +1,47 @@
+/*
+ * Copyright 2020, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ */
+
+#include <autoconf.h>
+#include <elfloader/gen_config.h>
+
+#ifdef CONFIG_ELFLOADER_BOOT_TIME
+#include <types.h>
+#include <fdt.h>
+
+#include "../boot_time.h"
+
+/*
+ * The boot phases are timed with the time CSR. Its frequency is not known to
+ * the hart, it is the 'timebase-frequency' in the /cpus node of the DTB.
+ */
+uint64_t arch_boot_time_counter(void)
+{
+#if __riscv_xlen == 32
+    uint32_t hi, lo, hi2;
+    do {
+        asm volatile("rdtimeh %0" : "=r"(hi));
+        asm volatile("rdtime %0" : "=r"(lo));
+        asm volatile("rdtimeh %0" : "=r"(hi2));
+    } while (hi != hi2);
+    return ((uint64_t)hi << 32) | lo;
+#else
+    uint64_t val;
+    asm volatile("rdtime %0" : "=r"(val));
+    return val;
+#endif
+}
+
+uint64_t arch_boot_time_frequency(void const *fdt)
+{
+    uint32_t freq;
+
+    if (!fdt || fdt_get_u32(fdt, "cpus", "timebase-frequency", &freq)) {
+        return 0;
+    }
+    return freq;
+}
+
+#endif /* CONFIG_ELFLOADER_BOOT_TIME */
@@ -12,3 +12,11 @@ int plat_console_putchar(unsigned int c)
     sbi_console_putchar(c);
     return 0;
 }
+
+int plat_console_write(char const *buf, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        sbi_console_putchar(buf[i]);
+    }
+    return 0;
+}
@@ -0,0 +1,106 @@
+/*
+ * Copyright 2020, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ */
+
+#include <autoconf.h>
+#include <elfloader/gen_config.h>
+
+#ifdef CONFIG_ELFLOADER_RISCV_ZKNH
+#include <types.h>
+
+#include "../crypt_sha256.h"
+#include "../crypt_copy.h"
+
+/*
+ * The Zknh extension has single instructions for the sigma functions of
+ * SHA-256. They are emitted with .insn, so that no toolchain support for the
+ * extension is needed. The encodings are OP-IMM with funct3 1 and the
+ * function in the immediate.
+ */
+#define ZKNH_SHA256SUM0 0x100
+#define ZKNH_SHA256SUM1 0x101
+#define ZKNH_SHA256SIG0 0x102
+#define ZKNH_SHA256SIG1 0x103
+
+#define ZKNH_OP(op, x) ({                                       \
+    word_t _r;                                                  \
+    asm(".insn i 0x13, 1, %0, %1, %2"                           \
+        : "=r"(_r) : "r"((word_t)(x)), "i"(op));                \
+    (uint32_t)_r;                                               \
+})
+
+#define Ch(x,y,z)  (z ^ (x & (y ^ z)))
+#define Maj(x,y,z) ((x & y) | (z & (x | y)))
+#define S0(x)      ZKNH_OP(ZKNH_SHA256SUM0, x)
+#define S1(x)      ZKNH_OP(ZKNH_SHA256SUM1, x)
+#define R0(x)      ZKNH_OP(ZKNH_SHA256SIG0, x)
+#define R1(x)      ZKNH_OP(ZKNH_SHA256SIG1, x)
+
+static const uint32_t K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static void zknh_processblock(uint32_t state[8], const uint8_t *buf, uint8_t *copy)
+{
+    uint32_t W[16], t1, t2, a, b, c, d, e, f, g, h;
+    int i;
+
+    for (i = 0; i < 16; i++) {
+        W[i] = crypt_load_be32(buf + 4 * i, copy ? copy + 4 * i : NULL);
+    }
+    a = state[0];
+    b = state[1];
+    c = state[2];
+    d = state[3];
+    e = state[4];
+    f = state[5];
+    g = state[6];
+    h = state[7];
+    for (i = 0; i < 64; i++) {
+        /* The message schedule only needs the last 16 words. */
+        if (i >= 16) {
+            W[i % 16] += R1(W[(i - 2) % 16]) + W[(i - 7) % 16] + R0(W[(i - 15) % 16]);
+        }
+        t1 = h + S1(e) + Ch(e, f, g) + K[i] + W[i % 16];
+        t2 = S0(a) + Maj(a, b, c);
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    state[5] += f;
+    state[6] += g;
+    state[7] += h;
+}
+
+unsigned long arch_sha256_blocks(uint32_t h[8], const uint8_t *buf,
+                                 unsigned long n, uint8_t *copy)
+{
+    for (unsigned long i = 0; i < n; i++, buf += 64) {
+        zknh_processblock(h, buf, copy);
+        if (copy) {
+            copy += 64;
+        }
+    }
+    return n;
+}
+
+#endif /* CONFIG_ELFLOADER_RISCV_ZKNH */
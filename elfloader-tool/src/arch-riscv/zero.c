@@ -0,0 +1,43 @@
+/*
+ * Copyright 2020, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ */
+
+#include <autoconf.h>
+#include <elfloader/gen_config.h>
+
+#ifdef CONFIG_ELFLOADER_RISCV_ZICBOZ
+#include <types.h>
+#include <strops.h>
+
+/*
+ * cbo.zero of the Zicboz extension zeroes the cache block that contains the
+ * address in rs1. The block size can't be read from the hart, so it has to be
+ * configured. The caches can't be turned off on RISC-V, so cbo.zero can always
+ * be used. It is emitted with .insn, so that no toolchain support for the
+ * extension is needed. The encoding is MISC-MEM with funct3 2 and the function
+ * in the immediate.
+ */
+#define CBO_ZERO    4
+
+compile_assert(cboz_block_size_power_of_2,
+               (CONFIG_ELFLOADER_RISCV_CBOZ_BLOCK_SIZE &
+                (CONFIG_ELFLOADER_RISCV_CBOZ_BLOCK_SIZE - 1)) == 0)
+
+size_t arch_zero_block_size(void)
+{
+    return CONFIG_ELFLOADER_RISCV_CBOZ_BLOCK_SIZE;
+}
+
+void arch_zero_blocks(void *s, size_t n)
+{
+    uintptr_t p = (uintptr_t)s;
+
+    for (; n > 0; n -= CONFIG_ELFLOADER_RISCV_CBOZ_BLOCK_SIZE,
+         p += CONFIG_ELFLOADER_RISCV_CBOZ_BLOCK_SIZE) {
+        asm volatile(".insn i 0x0f, 2, x0, %0, %1" :: "r"(p), "i"(CBO_ZERO) : "memory");
+    }
+}
+
+#endif /* CONFIG_ELFLOADER_RISCV_ZICBOZ */
@@ -0,0 +1,80 @@
+/*
+ * Copyright 2020, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ */
+
+#pragma once
+
+#include <autoconf.h>
+#include <elfloader/gen_config.h>
+#include <types.h>
+
+/*
+ * Boot phases. A record marks the end of a phase, so the time spent in it is
+ * the difference to the previous record. The first record has the counter
+ * value when main() was entered.
+ */
+enum boot_time_event {
+    BOOT_TIME_START = 0,
+    BOOT_TIME_DEVICES,      /* device and platform initialisation */
+    BOOT_TIME_ARCHIVE,      /* indexing the CPIO archive */
+    BOOT_TIME_HASH,         /* checking a hash of the image being loaded */
+    BOOT_TIME_SEGMENT,      /* loading a segment, 'arg' is its program header */
+    BOOT_TIME_IMAGE,        /* rest of loading an image, 'arg' is the image */
+    BOOT_TIME_PAGE_TABLES,  /* building the boot page tables */
+    BOOT_TIME_CACHES,       /* cache maintenance after loading */
+    BOOT_TIME_SMP,          /* starting the secondary cores */
+    BOOT_TIME_KERNEL_ENTRY, /* last record before jumping to the kernel */
+    BOOT_TIME_NUM_EVENTS
+};
+
+/*
+ * The records are also put into the property BOOT_TIME_FDT_PROPERTY of the
+ * /chosen node of the DTB that is passed to the kernel, so they can be read
+ * from userland. The data is a sequence of big endian 32-bit cells:
+ *
+ *     version (1), number of records, counter frequency in Hz (2 cells, 0 if
+ *     unknown), then for each record: event, arg, counter value (2 cells)
+ *
+ * The property always has room for BOOT_TIME_MAX_RECORDS records, unused ones
+ * are zero.
+ */
+#define BOOT_TIME_FDT_PROPERTY  "seL4,elfloader-boot-time"
+#define BOOT_TIME_VERSION       1
+#define BOOT_TIME_MAX_RECORDS   64
+#define BOOT_TIME_HEADER_CELLS  4
+#define BOOT_TIME_RECORD_CELLS  4
+#define BOOT_TIME_DATA_SIZE     (4 * (BOOT_TIME_HEADER_CELLS + \
+                                      BOOT_TIME_MAX_RECORDS * BOOT_TIME_RECORD_CELLS))
+/* Space the property needs in the DTB, including its token and name */
+#define BOOT_TIME_FDT_SPACE     (12 + BOOT_TIME_DATA_SIZE + sizeof(BOOT_TIME_FDT_PROPERTY))
+
+#ifdef CONFIG_ELFLOADER_BOOT_TIME
+
+/* Record the end of a boot phase. */
+void boot_time_mark(enum boot_time_event event, uint32_t arg);
+
+/*
+ * Add the records to the DTB at 'fdt' of 'size' bytes, which may grow to
+ * 'space' bytes. Later records are added to the DTB as well.
+ *
+ * Returns the new size of the DTB.
+ */
+size_t boot_time_attach_fdt(void *fdt, size_t size, size_t space);
+
+/* Print the recorded phases with their duration. */
+void boot_time_print(void);
+
+/*
+ * Architecture support: read the free running counter of the boot core, and
+ * get its frequency in Hz, or 0 if unknown. 'fdt' may be NULL.
+ */
+uint64_t arch_boot_time_counter(void);
+uint64_t arch_boot_time_frequency(void const *fdt);
+
+#else
+
+#define boot_time_mark(event, arg) do {} while (0)
+
+#endif /* CONFIG_ELFLOADER_BOOT_TIME */
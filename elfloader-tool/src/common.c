@@ -12,7 +12,6 @@
 #include <types.h>
 #include <strops.h>
 #include <binaries/elf/elf.h>
-#include <cpio/cpio.h>
 
 #include <elfloader.h>
 #include <fdt.h>
@@ -21,14 +20,23 @@
 #include "crypt_sha256.h"
 #elif CONFIG_HASH_MD5
 #include "crypt_md5.h"
+#elif CONFIG_HASH_BLAKE2S
+#include "crypt_blake2s.h"
 #endif
 
 #include "hash.h"
 
-#ifdef CONFIG_ELFLOADER_ROOTSERVERS_LAST
-#include <platform_info.h> // this provides memory_region
+#ifdef CONFIG_ELFLOADER_COMPRESS_IMAGES
+#include "lz4.h"
 #endif
 
+#include "hash_manifest.h"
+#include "cpio_index.h"
+#include "load_plan.h"
+#include "boot_time.h"
+
+#include <platform_info.h> // this provides memory_region
+
 #include <abort.h>
 
 extern char _bss[];
@@ -39,16 +47,76 @@ extern char _bss_end[];
  */
 void clear_bss(void)
 {
-    char *start = _bss;
-    char *end = _bss_end;
-    while (start < end) {
-        *start = 0;
-        start++;
+    /* This runs before main(), memset() must not rely on anything in .bss. */
+    memset(_bss, 0, _bss_end - _bss);
+}
+
+#ifdef CONFIG_ELFLOADER_CACHED_LOAD
+/*
+ * Get the bounds of memory region 'i' of the platform, 'end' is exclusive.
+ * platform_info.h can't be included in more than one file, this gives other
+ * parts of the ELF-loader access to the memory map.
+ *
+ * Returns 0 on success or -1 if there is no such region.
+ */
+int get_memory_region(unsigned int i, paddr_t *start, paddr_t *end)
+{
+    if (i >= (unsigned int)num_memory_regions) {
+        return -1;
     }
+    *start = memory_region[i].start;
+    *end = memory_region[i].end;
+    return 0;
 }
+#endif /* CONFIG_ELFLOADER_CACHED_LOAD */
 
 #define KEEP_HEADERS_SIZE BIT(PAGE_BITS)
 
+#ifdef CONFIG_ELFLOADER_PARALLEL_LOAD
+/* Spread copying and zeroing of the segments across all cores */
+#define load_copy smp_load_memcpy
+#define load_zero smp_load_memset
+#else
+#define load_copy memcpy
+#define load_zero memset
+#endif
+
+#ifdef CONFIG_ELFLOADER_CONSOLE_BUFFER
+/*
+ * Copy and zero in chunks, and send buffered console output to the UART in
+ * between. Each poll only fills the UART's FIFO, so it must come often enough
+ * to keep the output going. With several cores a chunk must still be large
+ * enough to be shared.
+ */
+#ifdef CONFIG_ELFLOADER_PARALLEL_LOAD
+#define LOAD_CHUNK_SIZE BIT(20)
+#else
+#define LOAD_CHUNK_SIZE BIT(14)
+#endif
+
+static void *load_memcpy(void *dest, void const *src, size_t n)
+{
+    for (size_t done = 0; done < n; done += LOAD_CHUNK_SIZE) {
+        load_copy((char *)dest + done, (char const *)src + done,
+                  MIN(n - done, LOAD_CHUNK_SIZE));
+        console_poll();
+    }
+    return dest;
+}
+
+static void *load_memset(void *s, int c, size_t n)
+{
+    for (size_t done = 0; done < n; done += LOAD_CHUNK_SIZE) {
+        load_zero((char *)s + done, c, MIN(n - done, LOAD_CHUNK_SIZE));
+        console_poll();
+    }
+    return s;
+}
+#else
+#define load_memcpy load_copy
+#define load_memset load_zero
+#endif
+
 /*
  * Determine if two intervals overlap.
  */
@@ -89,23 +157,415 @@ static int ensure_phys_range_valid(
         return -1;
     }
 
+#ifdef PLATFORM_INFO_NO_MEMORY_MAP
     return 0;
+#else
+    /*
+     * Uncompressed images are only verified after they have been copied, so
+     * this is all that keeps a corrupted image from being written anywhere
+     * but RAM.
+     */
+    for (int i = 0; i < num_memory_regions; i++) {
+        if (paddr_min >= memory_region[i].start &&
+            paddr_max <= memory_region[i].end) {
+            return 0;
+        }
+    }
+
+    printf("ERROR: image load address is outside of memory\n");
+    return -1;
+#endif
 }
 
 /*
- * Unpack an ELF file to the given physical address.
+ * Return the ELF headers of the image 'blob' from the archive. A compressed
+ * image has them in front of the compressed segment data, any other image is a
+ * plain ELF file.
  */
-static int unpack_elf_to_paddr(
+static void const *image_elf_headers(void const *blob, size_t blob_size)
+{
+#ifdef CONFIG_ELFLOADER_COMPRESS_IMAGES
+    void const *elf = lz4_image_open(blob, blob_size, NULL);
+    if (elf) {
+        return elf;
+    }
+#else
+    UNUSED_VARIABLE(blob_size);
+#endif
+    return blob;
+}
+
+/*
+ * Look up the load plan of the image 'image_name' in the archive and read it
+ * into 'storage'. The plan is named after the image, with the extension
+ * replaced by ".plan", e.g. "kernel.plan" for "kernel.elf" and
+ * "rootserver.plan" for "rootserver". Returns 0 and sets '*plan' to NULL if
+ * there is no plan, the image is unpacked by walking its program headers then.
+ * Returns -1 if the plan is invalid.
+ */
+static int find_load_plan(
+    char const *image_name,
+    struct load_plan *storage,
+    struct load_plan const **plan)
+{
+    *plan = NULL;
+
+#ifdef CONFIG_ELFLOADER_LOAD_PLAN
+    static char const plan_ext[] = ".plan";
+    char name[64];
+    size_t len = strlen(image_name);
+    for (size_t i = len; i > 0; i--) {
+        if (image_name[i - 1] == '.') {
+            len = i - 1;
+            break;
+        }
+    }
+    if (len > sizeof(name) - sizeof(plan_ext)) {
+        /* No plan can have been generated for such a name. */
+        return 0;
+    }
+    memcpy(name, image_name, len);
+    memcpy(name + len, plan_ext, sizeof(plan_ext));
+
+    size_t plan_size = 0;
+    void const *plan_blob = cpio_index_get_file(name, &plan_size);
+    if (plan_blob == NULL) {
+        return 0;
+    }
+    if (load_plan_open(storage, plan_blob, plan_size)) {
+        printf("ERROR: load plan '%s' invalid\n", name);
+        return -1;
+    }
+    *plan = storage;
+#else
+    UNUSED_VARIABLE(image_name);
+    UNUSED_VARIABLE(storage);
+#endif
+
+    return 0;
+}
+
+/*
+ * Get the memory bounds of an image from its load plan, if there is one, or
+ * from its ELF headers. Like elf_getMemoryBounds(), this returns 1 on success
+ * and anything else is an error.
+ */
+static int image_memory_bounds(
     void const *elf,
-    paddr_t dest_paddr)
+    struct load_plan const *plan,
+    int phys,
+    uint64_t *min,
+    uint64_t *max)
+{
+    if (plan) {
+        *min = phys ? plan->header.min_paddr : plan->header.min_vaddr;
+        *max = phys ? plan->header.max_paddr : plan->header.max_vaddr;
+        return 1;
+    }
+
+    return elf_getMemoryBounds(elf, phys, min, max);
+}
+
+/*
+ * Check that the loadable segments are sorted by their virtual address, as the
+ * ELF specification requires. The parts of the image that are not backed by the
+ * file are just the gaps between the segments then.
+ */
+static int load_segments_sorted(void const *elf)
+{
+    uint64_t prev_vaddr = 0;
+
+    for (unsigned int i = 0; i < elf_getNumProgramHeaders(elf); i++) {
+        if (elf_getProgramHeaderType(elf, i) != PT_LOAD) {
+            continue;
+        }
+        uint64_t vaddr = elf_getProgramHeaderVaddr(elf, i);
+        if (vaddr < prev_vaddr) {
+            return 0;
+        }
+        prev_vaddr = vaddr;
+    }
+
+    return 1;
+}
+
+#ifdef CONFIG_ELFLOADER_IN_PLACE_ROOTSERVER
+/*
+ * Check if the image 'blob' from the archive has been laid out by
+ * cmake-tool/helpers/in_place_image.py, so it can be run right where it is:
+ * the file data of the loadable segments is at the same offsets from a page
+ * aligned base in the file as the segments are from the start of the image,
+ * and the file is large enough to hold the whole image including its bss and
+ * a page for the program headers behind it.
+ *
+ * Returns the physical address of the image in the archive, or 0 if the image
+ * must be copied out.
+ */
+static paddr_t image_in_place(void const *blob, size_t blob_size)
+{
+    uint64_t min_vaddr, max_vaddr;
+    uint64_t base = 0;
+    int found = 0;
+
+    if (image_elf_headers(blob, blob_size) != blob ||
+        elf_getMemoryBounds(blob, 0, &min_vaddr, &max_vaddr) != 1 ||
+        !load_segments_sorted(blob)) {
+        return 0;
+    }
+
+    for (unsigned int i = 0; i < elf_getNumProgramHeaders(blob); i++) {
+        if (elf_getProgramHeaderType(blob, i) != PT_LOAD ||
+            elf_getProgramHeaderFileSize(blob, i) == 0) {
+            continue;
+        }
+        uint64_t offset = elf_getProgramHeaderOffset(blob, i);
+        uint64_t virt_offset = elf_getProgramHeaderVaddr(blob, i) - min_vaddr;
+        if (offset < virt_offset ||
+            (found && offset - virt_offset != base)) {
+            return 0;
+        }
+        base = offset - virt_offset;
+        found = 1;
+    }
+
+    uint64_t image_size = ROUND_UP(max_vaddr - min_vaddr, PAGE_BITS);
+    if (!found ||
+        base > blob_size ||
+        image_size + KEEP_HEADERS_SIZE > blob_size - base ||
+        !IS_ALIGNED((uintptr_t)blob + base, PAGE_BITS)) {
+        return 0;
+    }
+
+    return (paddr_t)((uintptr_t)blob + base);
+}
+#endif /* CONFIG_ELFLOADER_IN_PLACE_ROOTSERVER */
+
+/*
+ * Zero the part [start, end) of an image that is not backed by the ELF file.
+ */
+static void zero_image_gap(paddr_t start, paddr_t end)
+{
+    if (start >= end) {
+        return;
+    }
+
+#ifdef CONFIG_ELFLOADER_ASSUME_ZEROED_RAM
+    /* Only pages that also hold data from the file may not be zero. */
+    paddr_t head_end = ROUND_UP(start, PAGE_BITS);
+    paddr_t tail_start = ROUND_DOWN(end, PAGE_BITS);
+    if (head_end < tail_start) {
+        load_memset((void *)start, 0, head_end - start);
+        load_memset((void *)tail_start, 0, end - tail_start);
+        return;
+    }
+#endif
+
+    load_memset((void *)start, 0, end - start);
+}
+
+#ifndef CONFIG_HASH_NONE
+/*
+ * Hash the whole ELF file and copy the file data of the loadable segments to
+ * the image at 'dest_paddr' on the way, so that every byte of the file is read
+ * once. The file is hashed in order, the segments are visited by increasing
+ * file offset.
+ */
+static int hash_copy_elf(
+    void const *elf,
+    size_t elf_size,
+    paddr_t dest_paddr,
+    vaddr_t min_vaddr,
+    hashes_t *hashes)
+{
+    char const *file = elf;
+    unsigned int num_phdrs = elf_getNumProgramHeaders(elf);
+    /* Offset up to which the file has been hashed. */
+    size_t hashed = 0;
+    /* Last segment copied, the segments are ordered by (offset, index). */
+    size_t prev_offset = 0;
+    unsigned int prev = num_phdrs;
+
+    for (;;) {
+        unsigned int next = num_phdrs;
+        size_t next_offset = 0;
+
+        for (unsigned int i = 0; i < num_phdrs; i++) {
+            if (elf_getProgramHeaderType(elf, i) != PT_LOAD ||
+                elf_getProgramHeaderFileSize(elf, i) == 0) {
+                continue;
+            }
+            size_t offset = elf_getProgramHeaderOffset(elf, i);
+            if (prev < num_phdrs &&
+                (offset < prev_offset || (offset == prev_offset && i <= prev))) {
+                continue;
+            }
+            if (next == num_phdrs || offset < next_offset) {
+                next = i;
+                next_offset = offset;
+            }
+        }
+        if (next == num_phdrs) {
+            break;
+        }
+
+        size_t seg_size = elf_getProgramHeaderFileSize(elf, next);
+        if ((next_offset > elf_size) || (seg_size > elf_size - next_offset)) {
+            printf("ERROR: segment %d exceeds the ELF file\n", next);
+            return -1;
+        }
+        size_t seg_end = next_offset + seg_size;
+        vaddr_t seg_vaddr = elf_getProgramHeaderVaddr(elf, next);
+        char *seg_dest = (char *)(dest_paddr + (seg_vaddr - min_vaddr));
+
+        /* Hash the data in front of the segment that is not loaded. */
+        if (hashed < next_offset) {
+            hash_update(hashes, file + hashed, next_offset - hashed);
+            hashed = next_offset;
+        }
+        /* Segments can share data in the file, that is only hashed once. */
+        if (hashed > next_offset) {
+            size_t shared = MIN(hashed, seg_end) - next_offset;
+            memcpy(seg_dest, file + next_offset, shared);
+        }
+        if (hashed < seg_end) {
+            hash_update_copy(hashes, seg_dest + (hashed - next_offset),
+                             file + hashed, seg_end - hashed);
+            hashed = seg_end;
+        }
+
+        prev = next;
+        prev_offset = next_offset;
+    }
+
+    /* Hash the rest of the file after the last segment. */
+    if (hashed < elf_size) {
+        hash_update(hashes, file + hashed, elf_size - hashed);
+    }
+
+    return 0;
+}
+#endif /* !CONFIG_HASH_NONE */
+
+#ifdef CONFIG_ELFLOADER_LOAD_PLAN
+/*
+ * Unpack an image to the given physical address by executing its load plan.
+ * The operations were derived from the program headers at build time, here
+ * they are only checked against the bounds of the image and the file.
+ */
+static int unpack_load_plan(
+    struct load_plan const *plan,
+    void const *blob,
+    size_t blob_size,
+    paddr_t dest_paddr,
+    size_t zero_size)
+{
+    size_t elf_size = blob_size;
+
+#ifdef CONFIG_ELFLOADER_COMPRESS_IMAGES
+    struct lz4_image_stream stream;
+    int compressed = (lz4_image_open(blob, blob_size, &stream) != NULL);
+    if (compressed) {
+        elf_size = stream.elf_size;
+    }
+#endif
+
+    if (plan->header.elf_size != elf_size) {
+        printf("ERROR: load plan does not match the image\n");
+        return -1;
+    }
+
+    for (unsigned int i = 0; i < plan->header.num_ops; i++) {
+        struct load_plan_op op;
+        load_plan_get_op(plan, i, &op);
+
+        if ((op.dest_offset > zero_size) ||
+            (op.size > zero_size - op.dest_offset)) {
+            printf("ERROR: load plan operation %d invalid\n", i);
+            return -1;
+        }
+        paddr_t op_dest_paddr = dest_paddr + (size_t)op.dest_offset;
+
+        switch (op.type) {
+        case LOAD_PLAN_ZERO:
+            zero_image_gap(op_dest_paddr, op_dest_paddr + (size_t)op.size);
+            break;
+
+        case LOAD_PLAN_COPY:
+#ifdef CONFIG_ELFLOADER_COMPRESS_IMAGES
+            if (compressed) {
+                if (lz4_image_read(&stream, (void *)op_dest_paddr, (size_t)op.size)) {
+                    printf("ERROR: segment %d compressed data invalid\n", op.segment);
+                    return -1;
+                }
+                break;
+            }
+#endif
+            if ((op.src_offset > blob_size) ||
+                (op.size > blob_size - op.src_offset)) {
+                printf("ERROR: segment %d exceeds the ELF file\n", op.segment);
+                return -1;
+            }
+            /* Images run in place are already where they belong. */
+            if ((char const *)blob + (size_t)op.src_offset == (void *)op_dest_paddr) {
+                break;
+            }
+            load_memcpy((void *)op_dest_paddr,
+                        (char const *)blob + (size_t)op.src_offset,
+                        (size_t)op.size);
+            break;
+
+        default:
+            printf("ERROR: load plan operation %d invalid\n", i);
+            return -1;
+        }
+
+        if (op.type == LOAD_PLAN_COPY) {
+            boot_time_mark(BOOT_TIME_SEGMENT, op.segment);
+        }
+    }
+
+#ifdef CONFIG_ELFLOADER_COMPRESS_IMAGES
+    /* All segment data must have been decompressed by the plan. */
+    if (compressed && stream.pos != stream.end) {
+        printf("ERROR: load plan does not match the compressed image\n");
+        return -1;
+    }
+#endif
+
+    return 0;
+}
+#endif /* CONFIG_ELFLOADER_LOAD_PLAN */
+
+/*
+ * Unpack an ELF file to the given physical address. 'blob' is the image from
+ * the archive, which may be compressed. If 'hashes' is not NULL, the blob is
+ * hashed while the segments are copied. This is not supported for compressed
+ * images, they must be hashed before. If 'manifest' is not NULL, the segment
+ * data is checked against it chunk by chunk while it is loaded instead. If
+ * 'plan' is not NULL, the image is unpacked by executing its load plan.
+ */
+static int unpack_elf_to_paddr(
+    void const *blob,
+    size_t blob_size,
+    paddr_t dest_paddr,
+    hashes_t *hashes,
+    struct hash_manifest *manifest,
+    struct load_plan const *plan)
 {
     int ret;
+    void const *elf = image_elf_headers(blob, blob_size);
+
+#ifdef CONFIG_ELFLOADER_COMPRESS_IMAGES
+    /* The segment data of compressed images is read in program header order. */
+    struct lz4_image_stream stream;
+    int compressed = (lz4_image_open(blob, blob_size, &stream) != NULL);
+#endif
 
     /* Get the memory bounds. Unlike most other functions, this returns 1 on
      * success and anything else is an error.
      */
     uint64_t u64_min_vaddr, u64_max_vaddr;
-    ret = elf_getMemoryBounds(elf, 0, &u64_min_vaddr, &u64_max_vaddr);
+    ret = image_memory_bounds(elf, plan, 0, &u64_min_vaddr, &u64_max_vaddr);
     if (ret != 1) {
         printf("ERROR: Could not get image size\n");
         return -1;
@@ -114,7 +574,7 @@ static int unpack_elf_to_paddr(
     /* Check that image virtual address range is sane */
     if ((u64_min_vaddr > UINTPTR_MAX) || (u64_max_vaddr > UINTPTR_MAX)) {
         printf("ERROR: image virtual address [%"PRIu64"..%"PRIu64"] exceeds "
-               "UINTPTR_MAX (%u)\n",
+               "UINTPTR_MAX (%"PRIuPTR")\n",
                u64_min_vaddr, u64_max_vaddr, UINTPTR_MAX);
         return -1;
     }
@@ -122,14 +582,32 @@ static int unpack_elf_to_paddr(
     vaddr_t max_vaddr = (vaddr_t)u64_max_vaddr;
     vaddr_t min_vaddr = (vaddr_t)u64_min_vaddr;
     size_t image_size = max_vaddr - min_vaddr;
+    /* The image occupies whole pages, the rest of the last page is zeroed. */
+    size_t zero_size = ROUND_UP(image_size, PAGE_BITS);
 
-    if (dest_paddr + image_size < dest_paddr) {
+    if ((dest_paddr + image_size < dest_paddr) ||
+        (dest_paddr + zero_size < dest_paddr)) {
         printf("ERROR: image destination address integer overflow\n");
         return -1;
     }
 
-    /* Zero out all memory in the region, as the ELF file may be sparse. */
-    memset((void *)dest_paddr, 0, image_size);
+#ifdef CONFIG_ELFLOADER_LOAD_PLAN
+    if (plan) {
+        return unpack_load_plan(plan, blob, blob_size, dest_paddr, zero_size);
+    }
+#endif
+
+    /*
+     * Usually only the gaps between the segments and the parts of segments
+     * that are not in the file have to be zeroed. If the segments are not
+     * sorted, zero out all memory in the region first.
+     */
+    int sorted = load_segments_sorted(elf);
+    if (!sorted) {
+        load_memset((void *)dest_paddr, 0, zero_size);
+    }
+    /* Offset up to which the image has been zeroed or loaded. */
+    size_t loaded = 0;
 
     /* Load each segment in the ELF file. */
     for (unsigned int i = 0; i < elf_getNumProgramHeaders(elf); i++) {
@@ -161,12 +639,102 @@ static int unpack_elf_to_paddr(
             return -1;
         }
 
+        /* Zero the gap to the previous segment, including its bss. */
+        if (sorted) {
+            zero_image_gap(dest_paddr + loaded, seg_dest_paddr);
+        }
+
         /* Load data into memory. */
-        memcpy((void *)seg_dest_paddr, seg_src_addr, seg_size);
+#ifdef CONFIG_ELFLOADER_COMPRESS_IMAGES
+        if (compressed) {
+            ret = lz4_image_read(&stream, (void *)seg_dest_paddr, seg_size);
+            if (0 != ret) {
+                printf("ERROR: segment %d compressed data invalid\n", i);
+                return -1;
+            }
+            seg_src_addr = NULL;
+        }
+#endif
+        /* Images run in place are already where they belong. */
+        if (seg_src_addr == (void const *)seg_dest_paddr) {
+            seg_src_addr = NULL;
+        }
+#ifdef CONFIG_ELFLOADER_HASH_MANIFEST
+        if (manifest) {
+            ret = hash_manifest_load(manifest, (void *)seg_dest_paddr,
+                                     seg_src_addr, seg_size);
+            if (0 != ret) {
+                printf("ERROR: segment %d does not match the hash manifest\n", i);
+                return -1;
+            }
+        } else
+#else
+        UNUSED_VARIABLE(manifest);
+#endif
+        if (!hashes && seg_src_addr) {
+            load_memcpy((void *)seg_dest_paddr, seg_src_addr, seg_size);
+        }
+
+        if (seg_virt_offset + seg_size > loaded) {
+            loaded = seg_virt_offset + seg_size;
+        }
+
+        boot_time_mark(BOOT_TIME_SEGMENT, i);
+    }
+
+    /* Zero the bss of the last segment and the rest of the last page. */
+    if (sorted) {
+        zero_image_gap(dest_paddr + loaded, dest_paddr + zero_size);
+    }
+
+#ifdef CONFIG_ELFLOADER_HASH_MANIFEST
+    if (manifest && hash_manifest_close(manifest)) {
+        return -1;
+    }
+#endif
+
+#ifndef CONFIG_HASH_NONE
+    /* All segments are checked, copy them while hashing the file. */
+    if (hashes) {
+        return hash_copy_elf(elf, blob_size, dest_paddr, min_vaddr, hashes);
+    }
+#endif
+
+    return 0;
+}
+
+#ifndef CONFIG_HASH_NONE
+/*
+ * Compare the hash calculated for an image with the one from the archive.
+ */
+static int check_hash(
+    void const *file_hash,
+    uint8_t const *calculated_hash,
+    size_t len)
+{
+    /* Print the hash so the user can see they're the same or different */
+    if (LOG_ENABLED(DEBUG)) {
+        printf("Hash for ELF Input: ");
+        print_hash(calculated_hash, len);
+    }
+
+    /* Check the hashes are the same. There is no memcmp() in the striped down
+     * runtime lib of ELF Loader, so we compare here byte per byte. */
+    for (unsigned int i = 0; i < len; i++) {
+        if (((char const *)file_hash)[i] != ((char const *)calculated_hash)[i]) {
+            /* The hashes are not printed above at lower log levels. */
+            printf("ERROR: Hashes are different\n");
+            printf("  expected:   ");
+            print_hash(file_hash, len);
+            printf("  calculated: ");
+            print_hash(calculated_hash, len);
+            return -1;
+        }
     }
 
     return 0;
 }
+#endif /* !CONFIG_HASH_NONE */
 
 /*
  * Load an ELF file into physical memory at the given physical address.
@@ -175,12 +743,12 @@ static int unpack_elf_to_paddr(
  * address used.
  */
 static int load_elf(
-    void const *cpio,
-    size_t cpio_len,
     const char *name,
     void const *elf_blob,
     size_t elf_blob_size,
     char const *elf_hash_filename,
+    char const *elf_manifest_filename,
+    struct load_plan const *plan,
     paddr_t dest_paddr,
     int keep_headers,
     struct image_info *info,
@@ -188,18 +756,33 @@ static int load_elf(
 {
     int ret;
     uint64_t min_vaddr, max_vaddr;
+    void const *elf = image_elf_headers(elf_blob, elf_blob_size);
+    int in_place = 0;
+
+#ifdef CONFIG_ELFLOADER_IN_PLACE_ROOTSERVER
+    /* Only the user images (which keep their headers) may be run in place. */
+    if (keep_headers) {
+        paddr_t in_place_paddr = image_in_place(elf_blob, elf_blob_size);
+        if (in_place_paddr) {
+            dest_paddr = in_place_paddr;
+            in_place = 1;
+        }
+    }
+#endif
 
     /* Print diagnostics. */
-    printf("ELF-loading image '%s' to %p\n", name, dest_paddr);
+    log_info("ELF-loading image '%s' to %p%s\n", name, (void *)dest_paddr,
+             in_place ? " (in place)" : "");
 
     /* Get the memory bounds. Unlike most other functions, this returns 1 on
      * success and anything else is an error.
      */
-    ret = elf_getMemoryBounds(elf_blob, 0, &min_vaddr, &max_vaddr);
+    ret = image_memory_bounds(elf, plan, 0, &min_vaddr, &max_vaddr);
     if (ret != 1) {
         printf("ERROR: Could not get image bounds\n");
         return -1;
     }
+    uint64_t entry = plan ? plan->header.entry : elf_getEntryPoint(elf);
 
     /* round up size to the end of the page next page */
     max_vaddr = ROUND_UP(max_vaddr, PAGE_BITS);
@@ -220,19 +803,17 @@ static int load_elf(
 
 #ifdef CONFIG_HASH_NONE
 
-    UNUSED_VARIABLE(cpio);
-    UNUSED_VARIABLE(cpio_len);
-    UNUSED_VARIABLE(elf_blob_size);
     UNUSED_VARIABLE(elf_hash_filename);
+    UNUSED_VARIABLE(elf_manifest_filename);
+    hashes_t *unpack_hashes = NULL;
+    struct hash_manifest *manifest = NULL;
 
 #else
 
     /* Get the binary file that contains the Hash */
-    unsigned long cpio_file_size = 0;
-    void const *file_hash = cpio_get_file(cpio,
-                                          cpio_len,
-                                          elf_hash_filename,
-                                          &cpio_file_size);
+    size_t file_hash_len = 0;
+    void const *file_hash = cpio_index_get_file(elf_hash_filename,
+                                                &file_hash_len);
 
     /* If the file hash doesn't have a pointer, the file doesn't exist, so we
      * cannot confirm the file is what we expect.
@@ -242,52 +823,95 @@ static int load_elf(
         return -1;
     }
 
-    /* Ensure we can safely cast the CPIO API type to our preferred type. */
-    _Static_assert(sizeof(cpio_file_size) <= sizeof(size_t),
-                   "integer model mismatch");
-    size_t file_hash_len = (size_t)cpio_file_size;
-
 #ifdef CONFIG_HASH_SHA
     uint8_t calculated_hash[32];
     hashes_t hashes = { .hash_type = SHA_256 };
+#elif CONFIG_HASH_BLAKE2S
+    uint8_t calculated_hash[32];
+    hashes_t hashes = { .hash_type = BLAKE2S };
 #else
     uint8_t calculated_hash[16];
     hashes_t hashes = { .hash_type = MD5 };
 #endif
 
     if (file_hash_len < sizeof(calculated_hash)) {
-        printf("ERROR: hash file '%s' size %u invalid, expected at least %u\n",
+        printf("ERROR: hash file '%s' size %zu invalid, expected at least %zu\n",
                elf_hash_filename, file_hash_len, sizeof(calculated_hash));
     }
 
     /* Print the Hash for the user to see */
-    printf("Hash from ELF File: ");
-    print_hash(file_hash, sizeof(calculated_hash));
+    if (LOG_ENABLED(DEBUG)) {
+        printf("Hash from ELF File: ");
+        print_hash(file_hash, sizeof(calculated_hash));
+    }
 
-    get_hash(hashes, elf_blob, elf_blob_size, calculated_hash);
+    hashes_t *unpack_hashes = NULL;
+    struct hash_manifest *manifest = NULL;
 
-    /* Print the hash so the user can see they're the same or different */
-    printf("Hash for ELF Input: ");
-    print_hash(calculated_hash, sizeof(calculated_hash));
+#ifdef CONFIG_ELFLOADER_HASH_MANIFEST
+    /* The hash file holds the hash of the manifest, which has the hashes of
+     * the chunks of the segment data that are checked while they are loaded.
+     */
+    struct hash_manifest image_manifest;
+    size_t manifest_size = 0;
+    void const *manifest_blob = cpio_index_get_file(elf_manifest_filename,
+                                                    &manifest_size);
+    if (manifest_blob == NULL) {
+        printf("ERROR: hash manifest '%s' doesn't exist\n", elf_manifest_filename);
+        return -1;
+    }
 
-    /* Check the hashes are the same. There is no memcmp() in the striped down
-     * runtime lib of ELF Loader, so we compare here byte per byte. */
-    for (unsigned int i = 0; i < sizeof(calculated_hash); i++) {
-        if (((char const *)file_hash)[i] != ((char const *)calculated_hash)[i]) {
-            printf("ERROR: Hashes are different\n");
+    get_hash(hashes, manifest_blob, manifest_size, calculated_hash);
+    ret = check_hash(file_hash, calculated_hash, sizeof(calculated_hash));
+    if (0 != ret) {
+        return -1;
+    }
+    boot_time_mark(BOOT_TIME_HASH, 0);
+
+    ret = hash_manifest_open(&image_manifest, hashes, sizeof(calculated_hash),
+                             manifest_blob, manifest_size, elf);
+    if (0 != ret) {
+        return -1;
+    }
+    manifest = &image_manifest;
+#else
+    UNUSED_VARIABLE(elf_manifest_filename);
+
+    /* The hash of an uncompressed image is calculated while its segments are
+     * copied, so that the file is read only once. The image is checked after
+     * it has been unpacked then, which requires the memory map to keep the
+     * unverified program headers from pointing anywhere but RAM. Compressed
+     * images, and all images without a memory map, are checked before.
+     */
+#ifdef PLATFORM_INFO_NO_MEMORY_MAP
+    int hash_while_copying = 0;
+#else
+    int hash_while_copying = (elf == elf_blob && !in_place);
+#endif
+    if (hash_while_copying) {
+        hash_init(&hashes);
+        unpack_hashes = &hashes;
+    } else {
+        get_hash(hashes, elf_blob, elf_blob_size, calculated_hash);
+        ret = check_hash(file_hash, calculated_hash, sizeof(calculated_hash));
+        if (0 != ret) {
             return -1;
         }
+        boot_time_mark(BOOT_TIME_HASH, 0);
     }
+#endif /* CONFIG_ELFLOADER_HASH_MANIFEST */
 
 #endif  /* CONFIG_HASH_NONE */
 
     /* Print diagnostics. */
-    printf("  paddr=[%p..%p]\n", dest_paddr, dest_paddr + image_size - 1);
-    printf("  vaddr=[%p..%p]\n", (vaddr_t)min_vaddr, (vaddr_t)max_vaddr - 1);
-    printf("  virt_entry=%p\n", (vaddr_t)elf_getEntryPoint(elf_blob));
+    log_debug("  paddr=[%p..%p]\n", (void *)dest_paddr,
+              (void *)(dest_paddr + image_size - 1));
+    log_debug("  vaddr=[%p..%p]\n", (void *)(vaddr_t)min_vaddr,
+              (void *)((vaddr_t)max_vaddr - 1));
+    log_debug("  virt_entry=%p\n", (void *)(vaddr_t)entry);
 
     /* Ensure the ELF file is valid. */
-    ret = elf_checkFile(elf_blob);
+    ret = elf_checkFile(elf);
     if (0 != ret) {
         printf("ERROR: Invalid ELF file\n");
         return -1;
@@ -299,26 +923,47 @@ static int load_elf(
         return -1;
     }
 
-    /* Ensure that we region we want to write to is sane. */
-    ret = ensure_phys_range_valid(dest_paddr, dest_paddr + image_size);
+    /* Ensure that we region we want to write to is sane. An image that is run
+     * in place is within the ELF-loader's archive by design.
+     */
+    size_t used_size = image_size + (keep_headers ? KEEP_HEADERS_SIZE : 0);
+    if (dest_paddr + used_size < dest_paddr) {
+        printf("ERROR: image destination address integer overflow\n");
+        return -1;
+    }
+    ret = in_place ? 0 : ensure_phys_range_valid(dest_paddr, dest_paddr + used_size);
     if (0 != ret) {
-        printf("ERROR: Physical address range invalid\n");
+        printf("ERROR: Physical address range [%p..%p] invalid\n", (void *)dest_paddr,
+               (void *)(dest_paddr + used_size - 1));
         return -1;
     }
 
     /* Copy the data. */
-    ret = unpack_elf_to_paddr(elf_blob, dest_paddr);
+    ret = unpack_elf_to_paddr(elf_blob, elf_blob_size, dest_paddr, unpack_hashes,
+                              manifest, plan);
     if (0 != ret) {
-        printf("ERROR: Unpacking ELF to %p failed\n", dest_paddr);
+        printf("ERROR: Unpacking ELF to %p failed\n", (void *)dest_paddr);
         return -1;
     }
 
+#ifndef CONFIG_HASH_NONE
+    if (unpack_hashes) {
+        hash_sum(unpack_hashes, calculated_hash);
+        ret = check_hash(file_hash, calculated_hash, sizeof(calculated_hash));
+        if (0 != ret) {
+            return -1;
+        }
+        /* This includes copying the segments, which was done while hashing. */
+        boot_time_mark(BOOT_TIME_HASH, 0);
+    }
+#endif
+
     /* Record information about the placement of the image. */
     info->phys_region_start = dest_paddr;
     info->phys_region_end = dest_paddr + image_size;
     info->virt_region_start = (vaddr_t)min_vaddr;
     info->virt_region_end = (vaddr_t)max_vaddr;
-    info->virt_entry = (vaddr_t)elf_getEntryPoint(elf_blob);
+    info->virt_entry = (vaddr_t)entry;
     info->phys_virt_offset = dest_paddr - (vaddr_t)min_vaddr;
 
     /* Round up the destination address to the next page */
@@ -326,15 +971,15 @@ static int load_elf(
 
     if (keep_headers) {
         /* Put the ELF headers in this page */
-        uint32_t phnum = elf_getNumProgramHeaders(elf_blob);
+        uint32_t phnum = elf_getNumProgramHeaders(elf);
         uint32_t phsize;
         paddr_t source_paddr;
-        if (ISELF32(elf_blob)) {
-            phsize = ((struct Elf32_Header const *)elf_blob)->e_phentsize;
-            source_paddr = (paddr_t)elf32_getProgramHeaderTable(elf_blob);
+        if (ISELF32(elf)) {
+            phsize = ((struct Elf32_Header const *)elf)->e_phentsize;
+            source_paddr = (paddr_t)elf32_getProgramHeaderTable(elf);
         } else {
-            phsize = ((struct Elf64_Header const *)elf_blob)->e_phentsize;
-            source_paddr = (paddr_t)elf64_getProgramHeaderTable(elf_blob);
+            phsize = ((struct Elf64_Header const *)elf)->e_phentsize;
+            source_paddr = (paddr_t)elf64_getProgramHeaderTable(elf);
         }
         /* We have no way of sharing definitions with the kernel so we just
          * memcpy to a bunch of magic offsets. Explicit numbers for sizes
@@ -347,7 +992,8 @@ static int load_elf(
         dest_paddr += KEEP_HEADERS_SIZE;
     }
 
-    if (next_phys_addr) {
+    /* An image run in place does not use any memory after the previous one. */
+    if (next_phys_addr && !in_place) {
         *next_phys_addr = dest_paddr;
     }
     return 0;
@@ -400,32 +1046,47 @@ int load_images(
     void const *cpio = _archive_start;
     size_t cpio_len = _archive_start_end - _archive_start;
 
+#ifdef CONFIG_ELFLOADER_STRING_SELF_TEST
+    if (string_self_test()) {
+        return -1;
+    }
+#endif
+
+    /* Walk the archive once, all members are looked up in the index then. */
+    ret = cpio_index_init(cpio, cpio_len);
+    if (ret < 0) {
+        printf("ERROR: Invalid CPIO archive\n");
+        return -1;
+    }
+    boot_time_mark(BOOT_TIME_ARCHIVE, 0);
+
     /* Load kernel. */
-    unsigned long cpio_file_size = 0;
-    void const *kernel_elf_blob = cpio_get_file(cpio,
-                                                cpio_len,
-                                                "kernel.elf",
-                                                &cpio_file_size);
+    size_t kernel_elf_blob_size = 0;
+    void const *kernel_elf_blob = cpio_index_get_file("kernel.elf",
+                                                      &kernel_elf_blob_size);
     if (kernel_elf_blob == NULL) {
         printf("ERROR: No kernel image present in archive\n");
         return -1;
     }
+    void const *kernel_elf = image_elf_headers(kernel_elf_blob,
+                                               kernel_elf_blob_size);
 
-    /* Ensure we can safely cast the CPIO API type to our preferred type. */
-    _Static_assert(sizeof(cpio_file_size) <= sizeof(size_t),
-                   "integer model mismatch");
-    size_t kernel_elf_blob_size = (size_t)cpio_file_size;
-
-    ret = elf_checkFile(kernel_elf_blob);
+    ret = elf_checkFile(kernel_elf);
     if (ret != 0) {
         printf("ERROR: Kernel image not a valid ELF file\n");
         return -1;
     }
 
+    struct load_plan kernel_plan_storage, user_plan_storage;
+    struct load_plan const *kernel_plan, *user_plan;
+    if (find_load_plan("kernel.elf", &kernel_plan_storage, &kernel_plan)) {
+        return -1;
+    }
+
     /* Get physical memory bounds. Unlike most other functions, this returns 1
      * on success and anything else is an error.
      */
-    ret = elf_getMemoryBounds(kernel_elf_blob, 1, &kernel_phys_start,
+    ret = image_memory_bounds(kernel_elf, kernel_plan, 1, &kernel_phys_start,
                               &kernel_phys_end);
     if (1 != ret) {
         printf("ERROR: Could not get kernel memory bounds\n");
@@ -437,7 +1098,7 @@ int load_images(
 #ifdef CONFIG_ELFLOADER_INCLUDE_DTB
 
     if (chosen_dtb) {
-        printf("Looking for DTB in CPIO archive...");
+        log_debug("Looking for DTB in CPIO archive...");
         /*
          * Note the lack of newline in the above printf().  Normally one would
          * have an fflush(stdout) here to ensure that the message shows up on a
@@ -445,12 +1106,12 @@ int load_images(
          * devices).  But we are freestanding (on the "bare metal"), and using
          * our own unbuffered printf() implementation.
          */
-        dtb = cpio_get_file(cpio, cpio_len, "kernel.dtb", NULL);
+        dtb = cpio_index_get_file("kernel.dtb", NULL);
         if (dtb == NULL) {
-            printf("not found.\n");
+            log_debug("not found.\n");
         } else {
             has_dtb_cpio = 1;
-            printf("found at %p.\n", dtb);
+            log_debug("found at %p.\n", dtb);
         }
     }
 
@@ -476,21 +1137,38 @@ int load_images(
             return -1;
         }
 
+        /* Leave room for the properties the ELF-loader adds to the DTB. */
+        size_t dtb_space = dtb_size;
+#ifdef CONFIG_ELFLOADER_BOOT_TIME
+        dtb_space += BOOT_TIME_FDT_SPACE;
+#endif
+#ifdef CONFIG_ELFLOADER_CONSOLE_HANDOFF
+        dtb_space += CONSOLE_FDT_SPACE;
+#endif
+
         /* Make sure this is a sane thing to do */
         ret = ensure_phys_range_valid(next_phys_addr,
-                                      next_phys_addr + dtb_size);
+                                      next_phys_addr + dtb_space);
         if (0 != ret) {
             printf("ERROR: Physical address of DTB invalid\n");
             return -1;
         }
 
         memmove((void *)next_phys_addr, dtb, dtb_size);
+#ifdef CONFIG_ELFLOADER_BOOT_TIME
+        dtb_size = boot_time_attach_fdt((void *)next_phys_addr, dtb_size,
+                                        dtb_space);
+#endif
+#ifdef CONFIG_ELFLOADER_CONSOLE_HANDOFF
+        dtb_size = console_attach_fdt((void *)next_phys_addr, dtb_size,
+                                      dtb_space);
+#endif
         next_phys_addr += dtb_size;
         next_phys_addr = ROUND_UP(next_phys_addr, PAGE_BITS);
         dtb_phys_end = next_phys_addr;
 
-        printf("Loaded DTB from %p.\n", dtb);
-        printf("   paddr=[%p..%p]\n", dtb_phys_start, dtb_phys_end - 1);
+        log_info("Loaded DTB from %p.\n", dtb);
+        log_debug("   paddr=[%p..%p]\n", (void *)dtb_phys_start, (void *)(dtb_phys_end - 1));
         *chosen_dtb = (void *)dtb_phys_start;
         *chosen_dtb_size = dtb_size;
     } else {
@@ -498,12 +1176,12 @@ int load_images(
     }
 
     /* Load the kernel */
-    ret = load_elf(cpio,
-                   cpio_len,
-                   "kernel",
+    ret = load_elf("kernel",
                    kernel_elf_blob,
                    kernel_elf_blob_size,
                    "kernel.bin", // hash file
+                   "kernel.manifest", // hash manifest
+                   kernel_plan,
                    (paddr_t)kernel_phys_start,
                    0, // don't keep ELF headers
                    kernel_info,
@@ -513,6 +1191,7 @@ int load_images(
         printf("ERROR: Could not load kernel ELF\n");
         return -1;
     }
+    boot_time_mark(BOOT_TIME_IMAGE, 0);
 
     /*
      * Load userspace images.
@@ -523,15 +1202,14 @@ int load_images(
      * (n)'th CPU.
      */
     unsigned int user_elf_offset = 2;
-    cpio_get_entry(cpio, cpio_len, 0, &elf_filename, NULL);
+    cpio_index_get_entry(0, &elf_filename, NULL);
     ret = strcmp(elf_filename, "kernel.elf");
     if (0 != ret) {
         printf("ERROR: Kernel image not first image in archive\n");
         return -1;
     }
-    cpio_get_entry(cpio, cpio_len, 1, &elf_filename, NULL);
-    ret = strcmp(elf_filename, "kernel.dtb");
-    if (0 != ret) {
+    if (!cpio_index_get_entry(1, &elf_filename, NULL) ||
+        0 != strcmp(elf_filename, "kernel.dtb")) {
         if (has_dtb_cpio) {
             printf("ERROR: Kernel DTB not second image in archive\n");
             return -1;
@@ -545,19 +1223,22 @@ int load_images(
      * memory load_elf uses */
     unsigned int total_user_image_size = 0;
     for (unsigned int i = 0; i < max_user_images; i++) {
-        void const *user_elf = cpio_get_entry(cpio,
-                                              cpio_len,
-                                              i + user_elf_offset,
-                                              NULL,
-                                              NULL);
+        size_t elf_filesize = 0;
+        void const *user_elf = cpio_index_get_entry(i + user_elf_offset,
+                                                    &elf_filename,
+                                                    &elf_filesize);
         if (user_elf == NULL) {
             break;
         }
+        if (find_load_plan(elf_filename, &user_plan_storage, &user_plan)) {
+            return -1;
+        }
+        user_elf = image_elf_headers(user_elf, elf_filesize);
         /* Get the memory bounds. Unlike most other functions, this returns 1 on
          * success and anything else is an error.
          */
         uint64_t min_vaddr, max_vaddr;
-        ret = elf_getMemoryBounds(user_elf, 0, &min_vaddr, &max_vaddr);
+        ret = image_memory_bounds(user_elf, user_plan, 0, &min_vaddr, &max_vaddr);
         if (ret != 1) {
             printf("ERROR: Could not get image bounds\n");
             return -1;
@@ -577,35 +1258,35 @@ int load_images(
     *num_images = 0;
     for (unsigned int i = 0; i < max_user_images; i++) {
         /* Fetch info about the next ELF file in the archive. */
-        unsigned long cpio_file_size = 0;
-        void const *user_elf = cpio_get_entry(cpio,
-                                              cpio_len,
-                                              i + user_elf_offset,
-                                              &elf_filename,
-                                              &cpio_file_size);
+        size_t elf_filesize = 0;
+        void const *user_elf = cpio_index_get_entry(i + user_elf_offset,
+                                                    &elf_filename,
+                                                    &elf_filesize);
         if (user_elf == NULL) {
             break;
         }
-
-        /* Ensure we can safely cast the CPIO API type to our preferred type. */
-        _Static_assert(sizeof(cpio_file_size) <= sizeof(size_t),
-                       "integer model mismatch");
-        size_t elf_filesize = (size_t)cpio_file_size;
+        if (find_load_plan(elf_filename, &user_plan_storage, &user_plan)) {
+            return -1;
+        }
 
         /* Load the file into memory. */
-        ret = load_elf(cpio,
-                       cpio_len,
-                       elf_filename,
+        ret = load_elf(elf_filename,
                        user_elf,
                        elf_filesize,
                        "app.bin", // hash file
+                       "app.manifest", // hash manifest
+                       user_plan,
                        next_phys_addr,
                        1,  // keep ELF headers
                        &user_info[*num_images],
                        &next_phys_addr);
         if (0 != ret) {
-            printf("ERROR: Could not load user image ELF\n");
+            printf("ERROR: Could not load user image ELF '%s'\n", elf_filename);
+            /* The segments may have been copied already when the hash or
+             * hash manifest check failed, the image must not be run. */
+            return -1;
         }
+        boot_time_mark(BOOT_TIME_IMAGE, i + 1);
 
         *num_images = i + 1;
     }
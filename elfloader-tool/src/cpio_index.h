@@ -0,0 +1,46 @@
+/*
+ * Copyright 2020, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ */
+
+#pragma once
+
+#include <autoconf.h>
+#include <elfloader/gen_config.h>
+#include <types.h>
+
+/*
+ * Index of the members of the ELF-loader's CPIO archive. The index has a fixed
+ * capacity of CPIO_INDEX_MAX_ENTRIES, set with ElfloaderCpioIndexEntries.
+ * cpio_index_init() walks the archive once and fills it, all later lookups are
+ * served from the index instead of scanning the archive from its start again.
+ * Archives with more members still work, but lookups of the members beyond the
+ * capacity fall back to libcpio.
+ */
+#define CPIO_INDEX_MAX_ENTRIES  CONFIG_ELFLOADER_CPIO_INDEX_ENTRIES
+
+/*
+ * Build the index of 'archive'. Returns the number of members in the archive
+ * or -1 if it is malformed.
+ */
+int cpio_index_init(
+    void const *archive,
+    size_t len);
+
+/*
+ * Return the data of the member called 'name' and its size in 'size' (if not
+ * NULL), or NULL if there is no such member.
+ */
+void const *cpio_index_get_file(
+    char const *name,
+    size_t *size);
+
+/*
+ * Return the data of the 'n'th member of the archive, its name in 'name' and
+ * its size in 'size' (each if not NULL), or NULL if there is no such member.
+ */
+void const *cpio_index_get_entry(
+    unsigned int n,
+    char const **name,
+    size_t *size);
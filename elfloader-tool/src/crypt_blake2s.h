@@ -0,0 +1,28 @@
+/*
+ * Copyright 2020, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ */
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint32_t h[8];   /* hash state */
+    uint32_t t[2];   /* processed message length */
+    uint8_t buf[64]; /* message block buffer */
+    uint32_t buflen; /* bytes in the message block buffer */
+} blake2s_t;
+
+void blake2s_init(blake2s_t *s);
+void blake2s_sum(blake2s_t *s, uint8_t *md);
+void blake2s_update(blake2s_t *s, const void *m, unsigned long len);
+/* Same as blake2s_update(), but also copy the data to 'dest' */
+void blake2s_update_copy(blake2s_t *s, void *dest, const void *m, unsigned long len);
+
+#ifdef __cplusplus
+}
+#endif
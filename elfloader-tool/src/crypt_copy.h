@@ -0,0 +1,49 @@
+/*
+ * Copyright 2020, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ */
+
+#pragma once
+
+#include <types.h>
+#include <elfloader_common.h>
+
+/*
+ * The *_update_copy() functions of the hash implementations store each word of
+ * the message to the destination while it is loaded into the block function,
+ * so that the data is read from memory only once, even with the caches off.
+ */
+
+typedef uint32_t __attribute__((may_alias)) crypt_u32_alias;
+
+/*
+ * Load the little endian word at 'p' and, if 'copy' is not NULL, store it to
+ * 'copy'.
+ */
+static inline uint32_t crypt_load_le32(const uint8_t *p, uint8_t *copy)
+{
+    uint8_t b0 = p[0], b1 = p[1], b2 = p[2], b3 = p[3];
+    uint32_t w = b0 | (uint32_t)b1 << 8 | (uint32_t)b2 << 16 | (uint32_t)b3 << 24;
+
+    if (copy) {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        /* A single naturally aligned store, also safe for Device memory. */
+        if (((uintptr_t)copy & 3) == 0) {
+            *(crypt_u32_alias *)copy = w;
+            return w;
+        }
+#endif
+        copy[0] = b0;
+        copy[1] = b1;
+        copy[2] = b2;
+        copy[3] = b3;
+    }
+    return w;
+}
+
+/* Same for a big endian word. */
+static inline uint32_t crypt_load_be32(const uint8_t *p, uint8_t *copy)
+{
+    return __builtin_bswap32(crypt_load_le32(p, copy));
+}
@@ -25,6 +25,8 @@ typedef struct {
 void md5_init(md5_t *s);
 void md5_sum(md5_t *s, uint8_t *md);
 void md5_update(md5_t *s, const void *m, unsigned long len);
+/* Same as md5_update(), but also copy the data to 'dest' */
+void md5_update_copy(md5_t *s, void *dest, const void *m, unsigned long len);
 
 #ifdef __cplusplus
 }
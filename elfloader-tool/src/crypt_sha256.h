@@ -25,6 +25,11 @@ typedef struct {
 void sha256_init(sha256_t *s);
 void sha256_sum(sha256_t *s, uint8_t *md);
 void sha256_update(sha256_t *s, const void *m, unsigned long len);
+/* Same as sha256_update(), but also copy the data to 'dest' */
+void sha256_update_copy(sha256_t *s, void *dest, const void *m, unsigned long len);
+
+unsigned long arch_sha256_blocks(uint32_t h[8], const uint8_t *buf,
+                                 unsigned long n, uint8_t *copy);
 
 #ifdef __cplusplus
 }
@@ -15,6 +15,7 @@
 WEAK NORETURN void abort(void)
 {
     printf("abort() called.\n");
+    console_flush();
 
     while (1);
 
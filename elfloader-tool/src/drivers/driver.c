@@ -13,6 +13,21 @@
 #undef DRIVER_COMMON
 
 
+/*
+ * The driver bound to each device, as an index into _driver_list and into the
+ * driver's match table. It is resolved once by the first initialise_devices(),
+ * the initialisation after relocation and on the secondary cores reuses it.
+ * Indices are kept instead of pointers, so the binding is still valid in the
+ * relocated copy of the ELF-loader.
+ */
+struct device_binding {
+    int driver;
+    int match;
+};
+
+static struct device_binding device_bindings[ARRAY_SIZE(elfloader_devices)];
+static int devices_resolved;
+
 static int table_has_match(const char *compat, const struct dtb_match_table *table)
 {
     for (int i = 0; table[i].compatible != NULL; i++) {
@@ -24,66 +39,75 @@ static int table_has_match(const char *compat, const struct dtb_match_table *tab
     return -1;
 }
 
-static int init_device(struct elfloader_device *dev)
+static void resolve_device(struct elfloader_device *dev, struct device_binding *binding)
 {
-    struct elfloader_driver **drvp = __start__driver_list;
-
-    while (drvp < __stop__driver_list) {
-        struct elfloader_driver *drv = *drvp;
-        int ret = table_has_match(dev->compat, drv->match_table);
+    binding->driver = -1;
+    for (int i = 0; __start__driver_list + i < __stop__driver_list; i++) {
+        int ret = table_has_match(dev->compat, __start__driver_list[i]->match_table);
         if (ret >= 0) {
-            dev->drv = drv;
-            ret = drv->init(dev, drv->match_table[ret].match_data);
-            if (ret) {
-                return ret;
-            }
+            binding->driver = i;
+            binding->match = ret;
+            return;
         }
-        drvp++;
     }
-
-    return 0;
-
 }
 
-int initialise_devices(void)
+static void resolve_devices(void)
 {
+    if (devices_resolved) {
+        return;
+    }
     for (unsigned int i = 0; i < ARRAY_SIZE(elfloader_devices); i++) {
-        int ret = init_device(&elfloader_devices[i]);
-        if (ret) {
-            return ret;
-        }
+        resolve_device(&elfloader_devices[i], &device_bindings[i]);
     }
-
-    return 0;
+    devices_resolved = 1;
 }
 
-static int init_device_non_boot(struct elfloader_device *dev)
+/*
+ * Returns the driver bound to the device and its match data, or NULL if there
+ * is none.
+ */
+static struct elfloader_driver *device_driver(unsigned int i, void **match_data)
 {
-    struct elfloader_driver **drvp = __start__driver_list;
+    struct device_binding const *binding = &device_bindings[i];
+    if (binding->driver < 0) {
+        return NULL;
+    }
+    struct elfloader_driver *drv = __start__driver_list[binding->driver];
+    *match_data = drv->match_table[binding->match].match_data;
+    return drv;
+}
 
-    while (drvp < __stop__driver_list) {
-        struct elfloader_driver *drv = *drvp;
-        if (drv->init_on_secondary_cores) {
-            int ret = table_has_match(dev->compat, drv->match_table);
-            if (ret >= 0) {
-                dev->drv = drv;
-                ret = drv->init_on_secondary_cores(dev, drv->match_table[ret].match_data);
-                if (ret) {
-                    return ret;
-                }
+int initialise_devices(void)
+{
+    resolve_devices();
+    for (unsigned int i = 0; i < ARRAY_SIZE(elfloader_devices); i++) {
+        void *match_data;
+        struct elfloader_driver *drv = device_driver(i, &match_data);
+        if (drv) {
+            elfloader_devices[i].drv = drv;
+            int ret = drv->init(&elfloader_devices[i], match_data);
+            if (ret) {
+                return ret;
             }
         }
-        drvp++;
     }
+
     return 0;
 }
 
 int initialise_devices_non_boot(void)
 {
+    resolve_devices();
     for (unsigned int i = 0; i < ARRAY_SIZE(elfloader_devices); i++) {
-        int ret = init_device_non_boot(&elfloader_devices[i]);
-        if (ret) {
-            return ret;
+        void *match_data;
+        struct elfloader_driver *drv = device_driver(i, &match_data);
+        if (drv && drv->init_on_secondary_cores) {
+            elfloader_devices[i].drv = drv;
+            int ret = drv->init_on_secondary_cores(&elfloader_devices[i], match_data);
+            if (ret) {
+                return ret;
+            }
         }
     }
     return 0;
@@ -43,3 +43,8 @@ WEAK int plat_cpu_on(struct elfloader_cpu *cpu, void *entry, void *stack)
 
     return dev_get_smp(smp_ops)->cpu_on(smp_ops, cpu, entry, stack);
 }
+
+WEAK int plat_cpu_on_concurrent(void)
+{
+    return smp_ops && dev_get_smp(smp_ops)->concurrent;
+}
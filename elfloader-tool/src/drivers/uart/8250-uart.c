@@ -13,17 +13,29 @@
 #include <types.h>
 
 #define UTHR 0x00 /* UART Transmit Holding Register */
+#define UIIR 0x08 /* UART Interrupt Identification Register */
 #define ULSR 0x14 /* UART Line Status Register */
 #define ULSR_THRE (1 << 5) /* Transmit Holding Register Empty */
+#define UIIR_FIFO (3 << 6) /* FIFOs enabled */
+
+/* Transmit FIFO depth of a 16550, which is the least the compatibles have */
+#define UART_FIFO_DEPTH 16
 
 #define UART_REG(mmio, x) ((volatile uint32_t *)(((uintptr_t)mmio) + (x)))
 
+static int uart_8250_tx_ready(struct elfloader_device *dev)
+{
+    volatile void *mmio = dev->region_bases[0];
+
+    return (*UART_REG(mmio, ULSR) & ULSR_THRE) != 0;
+}
+
 static int uart_8250_putchar(struct elfloader_device *dev, unsigned int c)
 {
     volatile void *mmio = dev->region_bases[0];
 
     /* Wait until UART ready for the next character. */
-    while ((*UART_REG(mmio, ULSR) & ULSR_THRE) == 0);
+    while (!uart_8250_tx_ready(dev));
 
     /* Add character to the buffer. */
     *UART_REG(mmio, UTHR) = c;
@@ -31,6 +43,23 @@ static int uart_8250_putchar(struct elfloader_device *dev, unsigned int c)
     return 0;
 }
 
+static size_t uart_8250_write(struct elfloader_device *dev, char const *buf, size_t len)
+{
+    volatile void *mmio = dev->region_bases[0];
+    size_t n = 1;
+
+    /* With FIFOs enabled THRE means the whole FIFO is empty. */
+    while (!uart_8250_tx_ready(dev));
+    if ((*UART_REG(mmio, UIIR) & UIIR_FIFO) == UIIR_FIFO) {
+        n = MIN(len, UART_FIFO_DEPTH);
+    }
+    for (size_t i = 0; i < n; i++) {
+        *UART_REG(mmio, UTHR) = (unsigned char)buf[i];
+    }
+
+    return n;
+}
+
 static int uart_8250_init(struct elfloader_device *dev,
                           UNUSED void *match_data)
 {
@@ -47,6 +76,8 @@ static const struct dtb_match_table uart_8250_matches[] = {
 
 static const struct elfloader_uart_ops uart_8250_ops = {
     .putc = &uart_8250_putchar,
+    .tx_ready = &uart_8250_tx_ready,
+    .write = &uart_8250_write,
 };
 
 static const struct elfloader_driver uart_8250 = {
@@ -36,12 +36,22 @@
 
 #define UART_REG(mmio, x) ((volatile uint32_t *)((mmio) + (x)))
 
+/* Depth of the mini UART's transmit FIFO */
+#define MU_FIFO_DEPTH   8
+
+static int bcm2835_uart_tx_ready(struct elfloader_device *dev)
+{
+    volatile void *mmio = dev->region_bases[0];
+
+    return (*UART_REG(mmio, MU_LSR) & MU_LSR_TXIDLE) != 0;
+}
+
 static int bcm2835_uart_putchar(struct elfloader_device *dev, unsigned int c)
 {
     volatile void *mmio = dev->region_bases[0];
 
     /* Wait until UART ready for the next character. */
-    while (!(*UART_REG(mmio, MU_LSR) & MU_LSR_TXIDLE));
+    while (!bcm2835_uart_tx_ready(dev));
 
     /* Put in the register to be sent*/
     *UART_REG(mmio, MU_IO) = (c & 0xff);
@@ -49,6 +59,20 @@ static int bcm2835_uart_putchar(struct elfloader_device *dev, unsigned int c)
     return 0;
 }
 
+static size_t bcm2835_uart_write(struct elfloader_device *dev, char const *buf, size_t len)
+{
+    volatile void *mmio = dev->region_bases[0];
+    size_t n = MIN(len, MU_FIFO_DEPTH);
+
+    /* Wait until the FIFO is empty, then fill it. */
+    while (!bcm2835_uart_tx_ready(dev));
+    for (size_t i = 0; i < n; i++) {
+        *UART_REG(mmio, MU_IO) = (unsigned char)buf[i];
+    }
+
+    return n;
+}
+
 static int bcm2835_uart_init(struct elfloader_device *dev, UNUSED void *match_data)
 {
     uart_set_out(dev);
@@ -62,6 +86,8 @@ static const struct dtb_match_table bcm2835_uart_matches[] = {
 
 static const struct elfloader_uart_ops bcm2835_uart_ops = {
     .putc = &bcm2835_uart_putchar,
+    .tx_ready = &bcm2835_uart_tx_ready,
+    .write = &bcm2835_uart_write,
 };
 
 static const struct elfloader_driver bcm2835_uart = {
@@ -8,6 +8,8 @@
 #include <devices_gen.h>
 #include <drivers/uart.h>
 #include <elfloader_common.h>
+#include <printf.h>
+#include <fdt.h>
 
 static struct elfloader_device *uart_out = NULL;
 
@@ -28,10 +30,35 @@ volatile void *uart_get_mmio(void)
     return uart_out->region_bases[0];
 }
 
-WEAK int plat_console_putchar(unsigned int c)
+/*
+ * Write some of the 'len' > 0 characters to the UART, a burst if the driver
+ * supports it. Returns the number of characters written.
+ */
+static size_t uart_write(char const *buf, size_t len)
+{
+    struct elfloader_uart_ops const *ops = dev_get_uart(uart_out);
+
+    if (ops->write != NULL) {
+        return ops->write(uart_out, buf, len);
+    }
+    (void)ops->putc(uart_out, buf[0]);
+    return 1;
+}
+
+static void uart_write_all(char const *buf, size_t len)
+{
+    while (len > 0) {
+        size_t n = uart_write(buf, len);
+        buf += n;
+        len -= n;
+    }
+}
+
+/* Write a character to the UART right away. */
+static void uart_putchar(unsigned int c)
 {
     if (uart_out == NULL) {
-        return 0;
+        return;
     }
 
     /* Currently no driver really implements a return code for putc(), they all
@@ -43,6 +70,193 @@ WEAK int plat_console_putchar(unsigned int c)
     }
 
     (void)dev_get_uart(uart_out)->putc(uart_out, c);
+}
+
+#ifdef CONFIG_ELFLOADER_CONSOLE_BUFFER
+
+#define CONSOLE_BUFFER_SIZE CONFIG_ELFLOADER_CONSOLE_BUFFER_SIZE
+compile_assert(console_buffer_size_pow2,
+               CONSOLE_BUFFER_SIZE > 0 && (CONSOLE_BUFFER_SIZE & (CONSOLE_BUFFER_SIZE - 1)) == 0)
+
+/*
+ * Ring buffer of the console output. The positions only ever grow, the index
+ * into the buffer is the position modulo its size. Only the boot core uses it.
+ */
+static char console_buffer[CONSOLE_BUFFER_SIZE];
+static word_t console_head;   /* next position to write to */
+static word_t console_tail;   /* next position to send */
+static int console_cr_sent;   /* the '\r' for the '\n' at the tail is sent */
+
+/*
+ * The secondary cores can print while the boot core is using the buffer, e.g.
+ * in initialise_devices_non_boot() or abort(). The buffer is not locked, as the
+ * cores may run with different cache settings, so the other cores bypass it and
+ * write to the UART directly. The boot core runs on the first stack in
+ * core_stack_alloc, the other cores on stacks of their own.
+ */
+static int console_owned(void)
+{
+#if CONFIG_MAX_NUM_NODES > 1
+    extern char core_stack_alloc[];
+    char const *sp = __builtin_frame_address(0);
+
+    return sp >= core_stack_alloc && sp < core_stack_alloc + BIT(PAGE_BITS);
+#else
+    return 1;
+#endif
+}
+
+/*
+ * Send the buffered output up to position 'end'. Unless 'wait' is set, stop
+ * as soon as the UART would make us wait.
+ */
+static void console_send(word_t end, int wait)
+{
+    if (uart_out == NULL || !console_owned()) {
+        return;
+    }
+    struct elfloader_uart_ops const *ops = dev_get_uart(uart_out);
+
+    while (console_tail != end) {
+        if (!wait && (ops->tx_ready == NULL || !ops->tx_ready(uart_out))) {
+            return;
+        }
+        word_t index = console_tail % CONSOLE_BUFFER_SIZE;
+        char const *run = &console_buffer[index];
+        if ('\n' == run[0] && !console_cr_sent) {
+            (void)uart_write("\r", 1);
+            console_cr_sent = 1;
+            continue;
+        }
+        /* Send up to the next line break or the end of the buffer. */
+        size_t len = MIN(end - console_tail, CONSOLE_BUFFER_SIZE - index);
+        for (size_t i = 1; i < len; i++) {
+            if ('\n' == run[i]) {
+                len = i;
+                break;
+            }
+        }
+        console_tail += uart_write(run, len);
+        console_cr_sent = 0;
+    }
+}
+
+void console_poll(void)
+{
+    console_send(console_head, 0);
+}
+
+void console_flush(void)
+{
+    console_send(console_head, 1);
+}
+
+#ifdef CONFIG_ELFLOADER_CONSOLE_HANDOFF
+
+static char *console_fdt_data;
+
+size_t console_attach_fdt(void *fdt, size_t size, size_t space)
+{
+    /* One more byte than the buffer, so a full buffer is still terminated. */
+    console_fdt_data = fdt_add_property(fdt, space, "chosen", CONSOLE_FDT_PROPERTY,
+                                        CONSOLE_BUFFER_SIZE + 1);
+    if (!console_fdt_data) {
+        printf("Could not add the console property to the DTB\n");
+        return size;
+    }
+    return fdt_size(fdt);
+}
+
+void console_finish(void)
+{
+    if (console_fdt_data == NULL) {
+        console_flush();
+        return;
+    }
+    /* Hand over what the UART did not take yet, the property has room for a
+     * full buffer and the NUL terminator. */
+    console_poll();
+    for (word_t i = 0; console_tail != console_head; i++) {
+        console_fdt_data[i] = console_buffer[console_tail % CONSOLE_BUFFER_SIZE];
+        console_tail++;
+    }
+    console_cr_sent = 0;
+}
+
+#else
+
+void console_finish(void)
+{
+    console_flush();
+}
+
+#endif /* CONFIG_ELFLOADER_CONSOLE_HANDOFF */
+
+WEAK int plat_console_putchar(unsigned int c)
+{
+    if (!console_owned()) {
+        uart_putchar(c);
+        return 0;
+    }
+    if (console_head - console_tail == CONSOLE_BUFFER_SIZE) {
+        if (uart_out == NULL) {
+            /* Nowhere to send it yet, drop the oldest character. */
+            console_tail++;
+        } else {
+            console_send(console_tail + 1, 1);
+        }
+    }
+    console_buffer[console_head % CONSOLE_BUFFER_SIZE] = c;
+    console_head++;
 
     return 0;
 }
+
+WEAK int plat_console_write(char const *buf, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        plat_console_putchar(buf[i]);
+    }
+
+    return 0;
+}
+
+#else
+
+static int uart_console_putchar(unsigned int c)
+{
+    uart_putchar(c);
+    return 0;
+}
+
+WEAK int plat_console_putchar(unsigned int c) __attribute__((alias("uart_console_putchar")));
+
+WEAK int plat_console_write(char const *buf, size_t len)
+{
+    /* Overriding plat_console_putchar() still redirects all output. */
+    if (plat_console_putchar != uart_console_putchar) {
+        for (size_t i = 0; i < len; i++) {
+            plat_console_putchar(buf[i]);
+        }
+        return 0;
+    }
+
+    if (uart_out == NULL) {
+        return 0;
+    }
+
+    /* Send the lines in bursts, with a '\r' (CR) before every '\n' (LF). */
+    size_t start = 0;
+    for (size_t i = 0; i < len; i++) {
+        if ('\n' == buf[i]) {
+            uart_write_all(&buf[start], i - start);
+            uart_write_all("\r", 1);
+            start = i;
+        }
+    }
+    uart_write_all(&buf[start], len - start);
+
+    return 0;
+}
+
+#endif /* CONFIG_ELFLOADER_CONSOLE_BUFFER */
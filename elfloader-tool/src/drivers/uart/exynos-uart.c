@@ -35,12 +35,19 @@
 #define TX_EMPTY        (1<<2)
 #define TXBUF_EMPTY     (1<<1)
 
+static int exynos_uart_tx_ready(struct elfloader_device *dev)
+{
+    volatile void *mmio = dev->region_bases[0];
+
+    return (*UART_REG(mmio, UTRSTAT) & TXBUF_EMPTY) != 0;
+}
+
 static int exynos_uart_putchar(struct elfloader_device *dev, unsigned int c)
 {
     volatile void *mmio = dev->region_bases[0];
 
     /* Wait until UART ready for the next character. */
-    while (!(*UART_REG(mmio, UTRSTAT) & TXBUF_EMPTY));
+    while (!exynos_uart_tx_ready(dev));
 
     /* Put in the register to be sent*/
     *UART_REG(mmio, UTXH) = (c & 0xff);
@@ -61,6 +68,7 @@ static const struct dtb_match_table exynos_uart_matches[] = {
 
 static const struct elfloader_uart_ops exynos_uart_ops = {
     .putc = &exynos_uart_putchar,
+    .tx_ready = &exynos_uart_tx_ready,
 };
 
 static const struct elfloader_driver exynos_uart = {
@@ -28,12 +28,19 @@
 
 #define UART_REG(mmio, x) ((volatile uint32_t *)(mmio + (x)))
 
+static int imx_lpuart_tx_ready(struct elfloader_device *dev)
+{
+    volatile void *mmio = dev->region_bases[0];
+
+    return (*UART_REG(mmio, STAT) & STAT_TDRE) != 0;
+}
+
 static int imx_lpuart_putchar(struct elfloader_device *dev, unsigned int c)
 {
     volatile void *mmio = dev->region_bases[0];
 
     /* Wait to be able to transmit. */
-    while (!(*UART_REG(mmio, STAT) & STAT_TDRE)) { }
+    while (!imx_lpuart_tx_ready(dev));
 
     *UART_REG(mmio, TRANSMIT) = c;
 
@@ -54,6 +61,7 @@ static const struct dtb_match_table imx_lpuart_matches[] = {
 
 static const struct elfloader_uart_ops imx_lpuart_ops = {
     .putc = &imx_lpuart_putchar,
+    .tx_ready = &imx_lpuart_tx_ready,
 };
 
 static const struct elfloader_driver imx_lpuart = {
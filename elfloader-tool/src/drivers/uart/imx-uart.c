@@ -25,12 +25,22 @@
 
 #define UART_REG(mmio, x) ((volatile uint32_t *)(mmio + (x)))
 
+/* Depth of the transmit FIFO */
+#define UART_FIFO_DEPTH 32
+
+static int imx_uart_tx_ready(struct elfloader_device *dev)
+{
+    volatile void *mmio = dev->region_bases[0];
+
+    return (*UART_REG(mmio, UART_STAT2) & TXFE) != 0;
+}
+
 static int imx_uart_putchar(struct elfloader_device *dev, unsigned int c)
 {
     volatile void *mmio = dev->region_bases[0];
 
     /* Wait to be able to transmit. */
-    while (!(*UART_REG(mmio, UART_STAT2) & TXFE));
+    while (!imx_uart_tx_ready(dev));
 
     /* Transmit. */
     *UART_REG(mmio, UART_TRANSMIT) = c;
@@ -38,6 +48,20 @@ static int imx_uart_putchar(struct elfloader_device *dev, unsigned int c)
     return 0;
 }
 
+static size_t imx_uart_write(struct elfloader_device *dev, char const *buf, size_t len)
+{
+    volatile void *mmio = dev->region_bases[0];
+    size_t n = MIN(len, UART_FIFO_DEPTH);
+
+    /* Wait until the FIFO is empty, then fill it. */
+    while (!imx_uart_tx_ready(dev));
+    for (size_t i = 0; i < n; i++) {
+        *UART_REG(mmio, UART_TRANSMIT) = (unsigned char)buf[i];
+    }
+
+    return n;
+}
+
 static int imx_uart_init(struct elfloader_device *dev, UNUSED void *match_data)
 {
     uart_set_out(dev);
@@ -52,6 +76,8 @@ static const struct dtb_match_table imx_uart_matches[] = {
 
 static const struct elfloader_uart_ops imx_uart_ops = {
     .putc = &imx_uart_putchar,
+    .tx_ready = &imx_uart_tx_ready,
+    .write = &imx_uart_write,
 };
 
 static const struct elfloader_driver imx_uart = {
@@ -15,12 +15,19 @@
 #define UART_TX_FULL        BIT(21)
 #define UART_REG(mmio, x) ((volatile uint32_t *)(mmio + (x)))
 
+static int meson_uart_tx_ready(struct elfloader_device *dev)
+{
+    volatile void *mmio = dev->region_bases[0];
+
+    return (*UART_REG(mmio, UART_STATUS) & UART_TX_FULL) == 0;
+}
+
 static int meson_uart_putchar(struct elfloader_device *dev, unsigned int c)
 {
     volatile void *mmio = dev->region_bases[0];
 
     /* Wait to be able to transmit. */
-    while ((*UART_REG(mmio, UART_STATUS) & UART_TX_FULL));
+    while (!meson_uart_tx_ready(dev));
 
     /* Transmit. */
     *UART_REG(mmio, UART_WFIFO) = c;
@@ -41,6 +48,7 @@ static const struct dtb_match_table meson_uart_matches[] = {
 
 static const struct elfloader_uart_ops meson_uart_ops = {
     .putc = &meson_uart_putchar,
+    .tx_ready = &meson_uart_tx_ready,
 };
 
 static const struct elfloader_driver meson_uart = {
@@ -19,12 +19,19 @@
 
 #define UART_REG(mmio, x) ((volatile uint32_t *)(mmio + (x)))
 
+static int msm_uart_tx_ready(struct elfloader_device *dev)
+{
+    volatile void *mmio = dev->region_bases[0];
+
+    return (*UART_REG(mmio, USR) & USR_TXEMP) != 0;
+}
+
 static int msm_uart_putchar(struct elfloader_device *dev, unsigned int c)
 {
     volatile void *mmio = dev->region_bases[0];
 
     /* Wait for TX fifo to be empty */
-    while (!(*UART_REG(mmio, USR) & USR_TXEMP));
+    while (!msm_uart_tx_ready(dev));
     /* Tell the peripheral how many characters to send */
     *UART_REG(mmio, UNTX) = 1;
     /* Write the character into the FIFO */
@@ -46,6 +53,7 @@ static const struct dtb_match_table msm_uart_matches[] = {
 
 static const struct elfloader_uart_ops msm_uart_ops = {
     .putc = &msm_uart_putchar,
+    .tx_ready = &msm_uart_tx_ready,
 };
 
 static const struct elfloader_driver msm_uart = {
@@ -12,16 +12,29 @@
 
 #define UARTDR      0x000
 #define UARTFR      0x018
+#define UARTLCR_H   0x02c
 #define UARTFR_TXFF (1 << 5)
+#define UARTFR_TXFE (1 << 7)
+#define UARTLCR_H_FEN (1 << 4)
+
+/* Transmit FIFO depth of the earliest PL011 revisions, later ones have more */
+#define UART_FIFO_DEPTH 16
 
 #define UART_REG(mmio, x) ((volatile uint32_t *)(mmio + (x)))
 
+static int pl011_uart_tx_ready(struct elfloader_device *dev)
+{
+    volatile void *mmio = dev->region_bases[0];
+
+    return (*UART_REG(mmio, UARTFR) & UARTFR_TXFF) == 0;
+}
+
 int pl011_uart_putchar(struct elfloader_device *dev, unsigned int c)
 {
     volatile void *mmio = dev->region_bases[0];
 
     /* Wait until UART ready for the next character. */
-    while ((*UART_REG(mmio, UARTFR) & UARTFR_TXFF) != 0);
+    while (!pl011_uart_tx_ready(dev));
 
     /* Add character to the buffer. */
     *UART_REG(mmio, UARTDR) = (c & 0xff);
@@ -29,6 +42,25 @@ int pl011_uart_putchar(struct elfloader_device *dev, unsigned int c)
     return 0;
 }
 
+static size_t pl011_uart_write(struct elfloader_device *dev, char const *buf, size_t len)
+{
+    volatile void *mmio = dev->region_bases[0];
+    uint32_t fr;
+    size_t n = 1;
+
+    while ((fr = *UART_REG(mmio, UARTFR)) & UARTFR_TXFF);
+
+    /* An empty FIFO takes a whole burst, if the FIFO is enabled at all. */
+    if ((fr & UARTFR_TXFE) && (*UART_REG(mmio, UARTLCR_H) & UARTLCR_H_FEN)) {
+        n = MIN(len, UART_FIFO_DEPTH);
+    }
+    for (size_t i = 0; i < n; i++) {
+        *UART_REG(mmio, UARTDR) = (unsigned char)buf[i];
+    }
+
+    return n;
+}
+
 static int pl011_uart_init(struct elfloader_device *dev, UNUSED void *match_data)
 {
     uart_set_out(dev);
@@ -42,6 +74,8 @@ static const struct dtb_match_table pl011_uart_matches[] = {
 
 static const struct elfloader_uart_ops pl011_uart_ops = {
     .putc = &pl011_uart_putchar,
+    .tx_ready = &pl011_uart_tx_ready,
+    .write = &pl011_uart_write,
 };
 
 static const struct elfloader_driver pl011_uart = {
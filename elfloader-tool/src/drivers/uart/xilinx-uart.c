@@ -32,12 +32,22 @@
 
 #define UART_REG(mmio, x) ((volatile uint32_t *)(mmio + (x)))
 
+/* Depth of the transmit FIFO */
+#define XUARTPS_FIFO_DEPTH     64
+
+static int xilinx_uart_tx_ready(struct elfloader_device *dev)
+{
+    volatile void *mmio = dev->region_bases[0];
+
+    return (*UART_REG(mmio, XUARTPS_SR) & XUARTPS_SR_TXEMPTY) != 0;
+}
+
 static int xilinx_uart_putchar(struct elfloader_device *dev, unsigned int c)
 {
     volatile void *mmio = dev->region_bases[0];
 
     /* Wait to be able to transmit. */
-    while (!(*UART_REG(mmio, XUARTPS_SR) & XUARTPS_SR_TXEMPTY));
+    while (!xilinx_uart_tx_ready(dev));
 
     /* Transmit. */
     *UART_REG(mmio, XUARTPS_FIFO) = c;
@@ -45,6 +55,20 @@ static int xilinx_uart_putchar(struct elfloader_device *dev, unsigned int c)
     return 0;
 }
 
+static size_t xilinx_uart_write(struct elfloader_device *dev, char const *buf, size_t len)
+{
+    volatile void *mmio = dev->region_bases[0];
+    size_t n = MIN(len, XUARTPS_FIFO_DEPTH);
+
+    /* Wait until the FIFO is empty, then fill it. */
+    while (!xilinx_uart_tx_ready(dev));
+    for (size_t i = 0; i < n; i++) {
+        *UART_REG(mmio, XUARTPS_FIFO) = (unsigned char)buf[i];
+    }
+
+    return n;
+}
+
 static int xilinx_uart_init(struct elfloader_device *dev, UNUSED void *match_data)
 {
     volatile void *mmio = dev->region_bases[0];
@@ -64,6 +88,8 @@ static const struct dtb_match_table xilinx_uart_matches[] = {
 
 static const struct elfloader_uart_ops xilinx_uart_ops = {
     .putc = &xilinx_uart_putchar,
+    .tx_ready = &xilinx_uart_tx_ready,
+    .write = &xilinx_uart_write,
 };
 
 static const struct elfloader_driver xilinx_uart = {
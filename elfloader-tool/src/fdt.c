@@ -4,10 +4,25 @@
  * SPDX-License-Identifier: GPL-2.0-only
  */
 #include <types.h>
+#include <strops.h>
+#include <fdt.h>
+#include <elfloader_common.h>
 
 #define FDT_MAGIC (0xd00dfeed)
 /* Newest FDT version that we understand */
 #define FDT_MAX_VER 17
+/* Oldest FDT version that has all the header fields used when editing */
+#define FDT_MIN_EDIT_VER 17
+
+/* Offset of a header field, for use with fdt_get32() and fdt_set32() */
+#define FDT_HEADER(field)   __builtin_offsetof(struct fdt_header, field)
+
+/* Tokens of the structure block */
+#define FDT_BEGIN_NODE  1
+#define FDT_END_NODE    2
+#define FDT_PROP        3
+#define FDT_NOP         4
+#define FDT_END         9
 
 struct fdt_header {
     uint32_t magic;
@@ -44,3 +59,160 @@ size_t fdt_size(
     return be32_to_le(hdr->totalsize);
 }
 
+/*
+ * The structure block is made of big endian 32-bit words, the DTB itself is
+ * at least 8 byte aligned. The byte swap is its own inverse.
+ */
+static uint32_t fdt_get32(
+    void const *fdt,
+    size_t offset)
+{
+    return be32_to_le(*(uint32_t const *)((uint8_t const *)fdt + offset));
+}
+
+static void fdt_set32(
+    void *fdt,
+    size_t offset,
+    uint32_t val)
+{
+    *(uint32_t *)((uint8_t *)fdt + offset) = be32_to_le(val);
+}
+
+/*
+ * Return the offset of the first token after the start token of the top level
+ * node 'name' (ignoring any unit address), or 0 if there is no such node.
+ */
+static size_t fdt_find_node(
+    void const *fdt,
+    char const *name)
+{
+    size_t name_len = strlen(name);
+    size_t off = fdt_get32(fdt, FDT_HEADER(off_dt_struct));
+    size_t end = off + fdt_get32(fdt, FDT_HEADER(size_dt_struct));
+    int depth = 0;
+
+    while (off + 4 <= end) {
+        uint32_t token = fdt_get32(fdt, off);
+        off += 4;
+
+        switch (token) {
+        case FDT_BEGIN_NODE: {
+            char const *node = (char const *)fdt + off;
+            size_t len = strlen(node);
+            off += ROUND_UP(len + 1, 2);
+            depth++;
+            if (depth == 2 && strncmp(node, name, name_len) == 0 &&
+                (node[name_len] == '\0' || node[name_len] == '@')) {
+                return off;
+            }
+            break;
+        }
+        case FDT_END_NODE:
+            depth--;
+            break;
+        case FDT_PROP:
+            if (off + 8 > end) {
+                return 0;
+            }
+            off += 8 + ROUND_UP(fdt_get32(fdt, off), 2);
+            break;
+        case FDT_NOP:
+            break;
+        default:
+            return 0;
+        }
+    }
+
+    return 0;
+}
+
+int fdt_get_u32(
+    void const *fdt,
+    char const *node,
+    char const *prop,
+    uint32_t *val)
+{
+    if (fdt_size(fdt) == 0) {
+        return -1;
+    }
+
+    size_t off = fdt_find_node(fdt, node);
+    if (off == 0) {
+        return -1;
+    }
+    char const *strings = (char const *)fdt +
+                          fdt_get32(fdt, FDT_HEADER(off_dt_strings));
+
+    /* The properties of a node come before its sub nodes. */
+    for (;;) {
+        uint32_t token = fdt_get32(fdt, off);
+        if (token == FDT_NOP) {
+            off += 4;
+            continue;
+        }
+        if (token != FDT_PROP) {
+            return -1;
+        }
+        uint32_t len = fdt_get32(fdt, off + 4);
+        uint32_t name = fdt_get32(fdt, off + 8);
+        if (len == 4 && strcmp(strings + name, prop) == 0) {
+            *val = fdt_get32(fdt, off + 12);
+            return 0;
+        }
+        off += 12 + ROUND_UP(len, 2);
+    }
+}
+
+void *fdt_add_property(
+    void *fdt,
+    size_t space,
+    char const *node,
+    char const *prop,
+    size_t len)
+{
+    size_t total = fdt_size(fdt);
+    if (total == 0 || fdt_get32(fdt, FDT_HEADER(version)) < FDT_MIN_EDIT_VER) {
+        return NULL;
+    }
+
+    size_t off = fdt_find_node(fdt, node);
+    if (off == 0) {
+        return NULL;
+    }
+
+    /*
+     * The new property is inserted as the node's first one, which moves the
+     * rest of the structure block and the strings block up. Its name is
+     * appended to the strings block, so that must come last.
+     */
+    size_t rsvmap = fdt_get32(fdt, FDT_HEADER(off_mem_rsvmap));
+    size_t strings = fdt_get32(fdt, FDT_HEADER(off_dt_strings));
+    size_t strings_size = fdt_get32(fdt, FDT_HEADER(size_dt_strings));
+    size_t struct_size = fdt_get32(fdt, FDT_HEADER(size_dt_struct));
+    if (rsvmap > off || strings < off || strings + strings_size > total) {
+        return NULL;
+    }
+
+    size_t prop_size = 12 + ROUND_UP(len, 2);
+    size_t name_size = strlen(prop) + 1;
+    size_t new_total = MAX(total + prop_size, strings + prop_size + strings_size + name_size);
+    if (new_total > space) {
+        return NULL;
+    }
+
+    uint8_t *base = fdt;
+    memmove(base + off + prop_size, base + off, total - off);
+    memcpy(base + strings + prop_size + strings_size, prop, name_size);
+
+    fdt_set32(fdt, off, FDT_PROP);
+    fdt_set32(fdt, off + 4, len);
+    fdt_set32(fdt, off + 8, strings_size);
+    memset(base + off + 12, 0, prop_size - 12);
+
+    fdt_set32(fdt, FDT_HEADER(totalsize), new_total);
+    fdt_set32(fdt, FDT_HEADER(off_dt_strings), strings + prop_size);
+    fdt_set32(fdt, FDT_HEADER(size_dt_strings), strings_size + name_size);
+    fdt_set32(fdt, FDT_HEADER(size_dt_struct), struct_size + prop_size);
+
+    return base + off + 12;
+}
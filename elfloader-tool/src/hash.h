@@ -14,20 +14,25 @@
 
 #include "crypt_sha256.h"
 #include "crypt_md5.h"
+#include "crypt_blake2s.h"
 #include <types.h>
 
 /* enum to store the hashing methods */
 enum hash_methods {
     SHA_256,
-    MD5
+    MD5,
+    BLAKE2S
 };
 
-/* Structure that contains a structure for each hash type and an integer
+/* Structure that contains the state of the hash type used and an integer
  * representation of the hashing method used
  */
 typedef struct {
-    sha256_t sha_structure;
-    md5_t md5_structure;
+    union {
+        sha256_t sha_structure;
+        md5_t md5_structure;
+        blake2s_t blake2s_structure;
+    };
     unsigned int hash_type;
 } hashes_t;
 
@@ -37,6 +42,25 @@ void get_hash(
     size_t len,
     void *outputted_hash);
 
+/* Functions to calculate a hash piece by piece */
+void hash_init(
+    hashes_t *hashes);
+
+void hash_update(
+    hashes_t *hashes,
+    const void *data,
+    size_t len);
+
+void hash_update_copy(
+    hashes_t *hashes,
+    void *dest,
+    const void *src,
+    size_t len);
+
+void hash_sum(
+    hashes_t *hashes,
+    void *outputted_hash);
+
 void print_hash(
     void const *hash,
     size_t len);
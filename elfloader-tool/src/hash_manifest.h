@@ -0,0 +1,78 @@
+/*
+ * Copyright 2020, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ */
+
+#pragma once
+
+#include <types.h>
+
+#include "hash.h"
+
+/*
+ * Hash manifests, as produced by cmake-tool/helpers/hash_manifest.py, start
+ * with this header. It is followed by the digest of the program headers and
+ * the entry point of the image, and then by the digests of 'num_chunks' chunks
+ * of the file data of the loadable segments. The chunks are 'chunk_size' bytes
+ * and start anew with every loadable segment in program header order, so the
+ * last chunk of a segment may be shorter. All values are little endian.
+ *
+ * The program header digest is calculated over p_type (32 bit), p_paddr,
+ * p_vaddr, p_filesz and p_memsz (64 bit each) of every program header,
+ * followed by the entry point (64 bit).
+ */
+#define HASH_MANIFEST_MAGIC     "seL4HMF"
+#define HASH_MANIFEST_VERSION   1
+
+struct hash_manifest_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t digest_size;
+    uint32_t chunk_size;
+    uint32_t num_chunks;
+};
+
+/* Position in the chunk digests of a manifest */
+struct hash_manifest {
+    hashes_t hashes;
+    size_t digest_size;
+    uint8_t const *digest;
+    size_t chunk_size;
+    size_t chunks_left;
+};
+
+/*
+ * Check that 'manifest' is a valid manifest for digests of 'digest_size' bytes
+ * calculated with 'hashes', and that it matches the program headers and entry
+ * point of the ELF file 'elf'. Set up 'm' to check the first chunk.
+ *
+ * Returns 0 on success or -1 if the manifest is invalid.
+ */
+int hash_manifest_open(
+    struct hash_manifest *m,
+    hashes_t hashes,
+    size_t digest_size,
+    void const *manifest,
+    size_t manifest_size,
+    void const *elf);
+
+/*
+ * Load the next 'size' bytes of file data of a loadable segment to 'dest' and
+ * check each chunk against the manifest. If 'src' is NULL, the data is already
+ * at 'dest' and only checked. 'size' is the file size of the segment, it must
+ * be called once for each loadable segment in program header order.
+ *
+ * Returns 0 on success or -1 at the first chunk that does not match.
+ */
+int hash_manifest_load(
+    struct hash_manifest *m,
+    void *dest,
+    void const *src,
+    size_t size);
+
+/*
+ * Returns 0 if all chunks of the manifest have been checked or -1 otherwise.
+ */
+int hash_manifest_close(
+    struct hash_manifest const *m);
@@ -0,0 +1,75 @@
+/*
+ * Copyright 2020, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ */
+
+#pragma once
+
+#include <types.h>
+
+/*
+ * Load plans, as produced by cmake-tool/helpers/load_plan.py, start with this
+ * header. It has the memory bounds as returned by elf_getMemoryBounds() and
+ * the entry point of the image, and is followed by 'num_ops' operations that
+ * unpack the image. All values are little endian.
+ *
+ * A copy operation copies 'size' bytes from 'src_offset' in the ELF file to
+ * 'dest_offset' in the image, a zero operation zeroes 'size' bytes at
+ * 'dest_offset' in the image. There is a copy operation for each loadable
+ * segment in program header order, 'segment' is its program header index.
+ *
+ * The archive only aligns its members to 4 bytes, so the plan is read with
+ * memcpy().
+ */
+#define LOAD_PLAN_MAGIC     "seL4LPL"
+#define LOAD_PLAN_VERSION   1
+
+enum load_plan_op_type {
+    LOAD_PLAN_COPY = 1,
+    LOAD_PLAN_ZERO = 2,
+};
+
+struct load_plan_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t num_ops;
+    /* Size of the uncompressed ELF file the plan was generated for */
+    uint64_t elf_size;
+    uint64_t min_vaddr;
+    uint64_t max_vaddr;
+    uint64_t min_paddr;
+    uint64_t max_paddr;
+    uint64_t entry;
+};
+
+struct load_plan_op {
+    uint32_t type;
+    uint32_t segment;
+    uint64_t src_offset;
+    uint64_t dest_offset;
+    uint64_t size;
+};
+
+struct load_plan {
+    struct load_plan_header header;
+    uint8_t const *ops;
+};
+
+/*
+ * Check that 'blob' is a load plan and read its header into 'plan'.
+ *
+ * Returns 0 on success or -1 if 'blob' is not a valid load plan.
+ */
+int load_plan_open(
+    struct load_plan *plan,
+    void const *blob,
+    size_t blob_size);
+
+/*
+ * Read operation 'i' of 'plan' into 'op'.
+ */
+void load_plan_get_op(
+    struct load_plan const *plan,
+    unsigned int i,
+    struct load_plan_op *op);
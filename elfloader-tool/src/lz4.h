@@ -0,0 +1,74 @@
+/*
+ * Copyright 2020, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ */
+
+#pragma once
+
+#include <types.h>
+
+/*
+ * Compressed images, as produced by cmake-tool/helpers/lz4_image.py, start
+ * with this header. It is followed by the ELF header and the program headers
+ * of the image, padded to 8 bytes, and then by the file data of each loadable
+ * segment in program header order.
+ *
+ * The data of a segment is split into blocks of 'block_size' bytes (the last
+ * one may be shorter) that are LZ4 compressed independently. Each block is
+ * preceded by its size in the archive as a 32-bit little endian value. If
+ * LZ4_IMAGE_BLOCK_STORED is set in there, the block is stored uncompressed.
+ */
+#define LZ4_IMAGE_MAGIC         "seL4LZ4"
+#define LZ4_IMAGE_VERSION       2
+#define LZ4_IMAGE_BLOCK_STORED  0x80000000u
+
+struct lz4_image_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t elf_headers_size;
+    uint32_t block_size;
+    /* Size of the uncompressed ELF file */
+    uint32_t elf_size;
+};
+
+/* Position in the segment data of a compressed image */
+struct lz4_image_stream {
+    uint8_t const *pos;
+    uint8_t const *end;
+    size_t block_size;
+    size_t elf_size;
+};
+
+/*
+ * Decompress the LZ4 block 'src' of 'src_size' bytes to 'dest'. The block
+ * must decompress to exactly 'dest_size' bytes.
+ *
+ * Returns 0 on success or -1 if the block is malformed.
+ */
+int lz4_decompress_block(
+    void *dest,
+    size_t dest_size,
+    void const *src,
+    size_t src_size);
+
+/*
+ * Check if 'blob' is a compressed image. If so, return its ELF headers and set
+ * up 'stream' (if not NULL) to read the data of the first loadable segment.
+ *
+ * Returns NULL if 'blob' is not a compressed image.
+ */
+void const *lz4_image_open(
+    void const *blob,
+    size_t blob_size,
+    struct lz4_image_stream *stream);
+
+/*
+ * Decompress the next 'size' bytes of segment data from 'stream' to 'dest'.
+ *
+ * Returns 0 on success or -1 if the data is malformed.
+ */
+int lz4_image_read(
+    struct lz4_image_stream *stream,
+    void *dest,
+    size_t size);
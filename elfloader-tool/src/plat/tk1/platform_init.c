@@ -140,7 +140,7 @@ static void install_monitor_hook(void)
     uint32_t size = arm_monitor_vector_end - arm_monitor_vector;
     /* switch monitor mode if not already */
     switch_to_mon_mode();
-    printf("Copy monitor mode vector from %x to %x size %x\n", (arm_monitor_vector), MON_VECTOR_START, size);
+    printf("Copy monitor mode vector from %x to %x size %x\n", (uint32_t)(arm_monitor_vector), MON_VECTOR_START, size);
     memcpy((void *)MON_VECTOR_START, (void *)(arm_monitor_vector), size);
 
     asm volatile("mcr p15, 0, %0, c12, c0, 1"::"r"(MON_VECTOR_START));
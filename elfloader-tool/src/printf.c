@@ -221,18 +221,35 @@ static void vxprintf(
  * Simple printf/puts implementation.
  */
 
+/* The output is passed on to plat_console_write() in chunks of this size. */
+#define ARCH_WRITE_BUFF_SIZE 64
+
 typedef struct {
     unsigned int cnt;
+    unsigned int len;
+    char buff[ARCH_WRITE_BUFF_SIZE];
 } arch_write_char_ctx_t;
 
+static void arch_write_flush(
+    arch_write_char_ctx_t *ctx)
+{
+    if (ctx->len > 0) {
+        plat_console_write(ctx->buff, ctx->len);
+        ctx->len = 0;
+    }
+}
+
 static void arch_write_char(
     void *payload,
     int c)
 {
     arch_write_char_ctx_t *ctx = payload;
 
-    plat_console_putchar(c);
-    /* do do not really know what plat_console_putchar() does effectively, all
+    ctx->buff[ctx->len++] = c;
+    if (ctx->len == ARCH_WRITE_BUFF_SIZE) {
+        arch_write_flush(ctx);
+    }
+    /* do do not really know what plat_console_write() does effectively, all
      * we do know is that we have given it one character.
      */
     ctx->cnt++;
@@ -247,6 +264,7 @@ int printf(
     va_start(args, format);
     vxprintf(arch_write_char, &ctx, format, args);
     va_end(args);
+    arch_write_flush(&ctx);
     return (int)ctx.cnt;
 }
 
@@ -256,6 +274,7 @@ int puts(
     arch_write_char_ctx_t ctx = {0};
     write_string(arch_write_char, &ctx, str);
     arch_write_char(&ctx, '\n');
+    arch_write_flush(&ctx);
     return (int)ctx.cnt;
 }
 
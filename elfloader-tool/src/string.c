@@ -4,9 +4,12 @@
  * SPDX-License-Identifier: GPL-2.0-only
  */
 
+#include <autoconf.h>
+#include <elfloader/gen_config.h>
+
 #include <strops.h>
 #include <printf.h>
-#include <abort.h>
+#include <elfloader_common.h>
 
 #define BYTE_PER_WORD   sizeof(word_t)
 
@@ -61,11 +64,31 @@ int strncmp(const char *s1, const char *s2, size_t n)
     return 0;
 }
 
-void *memset(void *s, int c, size_t n)
+/*
+ * Zeroing with cache block instructions is only used for ranges of at least
+ * this many blocks, so it pays off against the extra head and tail handling.
+ */
+#define ZERO_BLOCKS_MIN 4
+
+/*
+ * Architectures can provide a way to zero whole cache blocks, e.g. DC ZVA on
+ * AArch64. This returns the block size in bytes if blocks can be zeroed right
+ * now, which usually needs the data caches to be enabled, or 0 otherwise.
+ */
+WEAK size_t arch_zero_block_size(void)
 {
-    char *mem = (char *)s;
+    return 0;
+}
+
+WEAK void arch_zero_blocks(void *s, size_t n)
+{
+    (void)s;
+    (void)n;
+}
 
 #ifdef HAS_MAY_ALIAS
+static void fill_words(char *mem, int c, size_t n)
+{
     /* fill byte by byte until word aligned */
     for (; (uintptr_t)mem % BYTE_PER_WORD != 0 && n > 0; mem++, n--) {
         *mem = c;
@@ -74,7 +97,13 @@ void *memset(void *s, int c, size_t n)
      * byte size actually. Assume words have 3 byte, then 0xffffff / 0xff is
      * 0x010101, and 0x010101 * 0xab is 0xababab  */
     u_alias fill = (((u_alias)(-1)) / 0xff) * (unsigned char)c;
-    /* do as many word writes as we can */
+    /* do four word writes per iteration for the bulk, then single ones */
+    for (; n >= 4 * BYTE_PER_WORD; n -= 4 * BYTE_PER_WORD, mem += 4 * BYTE_PER_WORD) {
+        ((u_alias *)mem)[0] = fill;
+        ((u_alias *)mem)[1] = fill;
+        ((u_alias *)mem)[2] = fill;
+        ((u_alias *)mem)[3] = fill;
+    }
     for (; n > BYTE_PER_WORD - 1; n -= BYTE_PER_WORD, mem += BYTE_PER_WORD) {
         *(u_alias *)mem = fill;
     }
@@ -82,6 +111,26 @@ void *memset(void *s, int c, size_t n)
     for (; n > 0; n--, mem++) {
         *mem = c;
     }
+}
+#endif
+
+void *memset(void *s, int c, size_t n)
+{
+    char *mem = (char *)s;
+
+#ifdef HAS_MAY_ALIAS
+    size_t block = (c == 0) ? arch_zero_block_size() : 0;
+
+    if (block != 0 && n >= ZERO_BLOCKS_MIN * block) {
+        /* Zero the blocks in the middle, and the parts around them by hand */
+        uintptr_t first = ((uintptr_t)mem + block - 1) & ~(uintptr_t)(block - 1);
+        uintptr_t last = ((uintptr_t)mem + n) & ~(uintptr_t)(block - 1);
+        fill_words(mem, 0, first - (uintptr_t)mem);
+        arch_zero_blocks((void *)first, last - first);
+        fill_words((char *)last, 0, (uintptr_t)mem + n - last);
+    } else {
+        fill_words(mem, c, n);
+    }
 #else
     /* Without the __may__alias__ attribute we cannot safely do word writes
      * so fallback to bytes */
@@ -94,6 +143,62 @@ void *memset(void *s, int c, size_t n)
     return s;
 }
 
+/*
+ * Copy 'n' bytes between buffers that can't both be word aligned. After dest
+ * is aligned with single bytes, every word stored is merged with shifts from
+ * the two aligned source words it straddles, so only aligned words are loaded
+ * and stored. This also works with strict alignment checking, e.g. before the
+ * MMU is enabled. Copying upwards, it is also correct for overlapping buffers
+ * with dest below src. The assembly memcpy() variants branch here for larger
+ * copies, too.
+ */
+void *memcpy_misaligned(void *dest, const void *src, size_t n)
+{
+    unsigned char *d = (unsigned char *)dest;
+    const unsigned char *s = (const unsigned char *)src;
+
+#ifdef HAS_MAY_ALIAS
+    /* The merging below assumes little endian, which is all seL4 runs on */
+    compile_assert(memcpy_misaligned_little_endian,
+                   __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+
+    /* copy byte by byte until dest is word aligned */
+    for (; (uintptr_t)d % BYTE_PER_WORD != 0 && n > 0; d++, s++, n--) {
+        *d = *s;
+    }
+
+    size_t off = (uintptr_t)s % BYTE_PER_WORD;
+    if (off != 0 && n >= 2 * BYTE_PER_WORD) {
+        /* 'carry' holds the 'head' bytes of src up to its next word boundary */
+        size_t head = BYTE_PER_WORD - off;
+        u_alias carry = 0;
+        size_t i;
+        for (i = 0; i < head; i++) {
+            carry |= (u_alias)s[i] << (8 * i);
+        }
+        s += head;
+        /* Only load whole words that are within src */
+        for (; n >= head + BYTE_PER_WORD; n -= BYTE_PER_WORD, s += BYTE_PER_WORD, d += BYTE_PER_WORD) {
+            u_alias w = *(const u_alias *)s;
+            *(u_alias *)d = carry | (w << (8 * head));
+            carry = w >> (8 * off);
+        }
+        /* The bytes in 'carry' are copied again below */
+        s -= head;
+    }
+#endif
+
+    /* copy any remainder byte by byte */
+    for (; n > 0; d++, s++, n--) {
+        *d = *s;
+    }
+
+    return dest;
+}
+
+#ifndef CONFIG_ELFLOADER_ARCH_MEMCPY
+/* Otherwise memmove() and memcpy() are in src/arch-<arch>/.../memcpy.S */
+
 void *memmove(void *restrict dest, const void *restrict src, size_t n)
 {
     unsigned char *d = (unsigned char *)dest;
@@ -126,49 +231,21 @@ void *memcpy(void *restrict dest, const void *restrict src, size_t n)
     unsigned char *d = (unsigned char *)dest;
     const unsigned char *s = (const unsigned char *)src;
 
-    /* For ARM, we also need to consider if src is aligned.           *
-     * There are two cases: (1) If rs == 0 and rd == 0, dest          *
-     * and src are copy_unit-aligned. (2) If (rs == rd && rs != 0),   *
-     * src and dest can be made copy_unit-aligned by copying rs bytes *
-     * first. (1) is a special case of (2).                           */
-
-    size_t copy_unit = BYTE_PER_WORD;
-    while (1) {
-        int rs = (uintptr_t)s % copy_unit;
-        int rd = (uintptr_t)d % copy_unit;
-        if (rs == rd) {
-            break;
-        }
-        if (copy_unit == 1) {
-            break;
-        }
-        copy_unit >>= 1;
+#ifdef HAS_MAY_ALIAS
+    /* If src and dest can't both be word aligned, shift and merge the words
+     * of src. Copying in a smaller unit both can be aligned to would drop
+     * to single bytes for an odd difference. */
+    if (((uintptr_t)s - (uintptr_t)d) % BYTE_PER_WORD != 0) {
+        return memcpy_misaligned(dest, src, n);
     }
 
-#ifdef HAS_MAY_ALIAS
-    /* copy byte by byte until copy-unit aligned */
-    for (; (uintptr_t)d % copy_unit != 0 && n > 0; d++, s++, n--) {
+    /* copy byte by byte until word aligned */
+    for (; (uintptr_t)d % BYTE_PER_WORD != 0 && n > 0; d++, s++, n--) {
         *d = *s;
     }
-    /* copy unit by unit as long as we can */
-    for (; n > copy_unit - 1; n -= copy_unit, s += copy_unit, d += copy_unit) {
-        switch (copy_unit) {
-        case 8:
-            *(uint64_t *)d = *(const uint64_t *)s;
-            break;
-        case 4:
-            *(uint32_t *)d = *(const uint32_t *)s;
-            break;
-        case 2:
-            *(uint16_t *)d = *(const uint16_t *)s;
-            break;
-        case 1:
-            *(uint8_t *)d = *(const uint8_t *)s;
-            break;
-        default:
-            printf("Invalid copy unit %ld\n", copy_unit);
-            abort();
-        }
+    /* copy word by word as long as we can */
+    for (; n > BYTE_PER_WORD - 1; n -= BYTE_PER_WORD, s += BYTE_PER_WORD, d += BYTE_PER_WORD) {
+        *(u_alias *)d = *(const u_alias *)s;
     }
     /* copy any remainder byte by byte */
     for (; n > 0; d++, s++, n--) {
@@ -183,3 +260,108 @@ void *memcpy(void *restrict dest, const void *restrict src, size_t n)
 
     return dest;
 }
+#endif /* !CONFIG_ELFLOADER_ARCH_MEMCPY */
+
+#ifdef CONFIG_ELFLOADER_STRING_SELF_TEST
+
+#define SELF_TEST_SIZE  512
+#define SELF_TEST_GUARD 0xee
+
+static unsigned char self_test_buf[2 * SELF_TEST_SIZE] ALIGN(16);
+
+static unsigned char self_test_pattern(size_t i)
+{
+    return (i * 7 + 3) & 0xff;
+}
+
+/* Fill the first half of the buffer with the pattern, the second with guards */
+static void self_test_fill(void)
+{
+    size_t i;
+    for (i = 0; i < SELF_TEST_SIZE; i++) {
+        self_test_buf[i] = self_test_pattern(i);
+        self_test_buf[SELF_TEST_SIZE + i] = SELF_TEST_GUARD;
+    }
+}
+
+/*
+ * Check that only [start, start + n) of the buffer was changed, and that it
+ * holds the pattern from 'from' on, or 'c' if 'from' is negative.
+ */
+static int self_test_check(size_t start, size_t n, long from, int c)
+{
+    size_t i;
+    for (i = 0; i < 2 * SELF_TEST_SIZE; i++) {
+        unsigned char expect;
+        if (i >= start && i < start + n) {
+            expect = (from < 0) ? (unsigned char)c : self_test_pattern(from + i - start);
+        } else {
+            expect = (i < SELF_TEST_SIZE) ? self_test_pattern(i) : SELF_TEST_GUARD;
+        }
+        if (self_test_buf[i] != expect) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static size_t const self_test_sizes[] = {
+    0, 1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 32, 33, 63, 64, 65, 127, 128,
+    129, 255, 300
+};
+
+int string_self_test(void)
+{
+    size_t s, d, k;
+
+    for (k = 0; k < ARRAY_SIZE(self_test_sizes); k++) {
+        size_t n = self_test_sizes[k];
+
+        for (s = 0; s < 16; s++) {
+            for (d = 0; d < 16; d++) {
+                void *dest = &self_test_buf[SELF_TEST_SIZE + d];
+
+                self_test_fill();
+                if (memcpy(dest, &self_test_buf[s], n) != dest ||
+                    self_test_check(SELF_TEST_SIZE + d, n, s, 0)) {
+                    printf("ERROR: memcpy() self test failed, src offset %u, "
+                           "dest offset %u, size %u\n",
+                           (unsigned int)s, (unsigned int)d, (unsigned int)n);
+                    return -1;
+                }
+            }
+        }
+
+        /* Overlapping copies in both directions */
+        for (s = 0; s < 40; s++) {
+            for (d = 0; d < 40; d++) {
+                void *dest = &self_test_buf[d];
+
+                self_test_fill();
+                if (memmove(dest, &self_test_buf[s], n) != dest ||
+                    self_test_check(d, n, s, 0)) {
+                    printf("ERROR: memmove() self test failed, src offset %u, "
+                           "dest offset %u, size %u\n",
+                           (unsigned int)s, (unsigned int)d, (unsigned int)n);
+                    return -1;
+                }
+            }
+        }
+
+        for (d = 0; d < 16; d++) {
+            void *dest = &self_test_buf[SELF_TEST_SIZE + d];
+
+            self_test_fill();
+            if (memset(dest, 0xa5, n) != dest ||
+                self_test_check(SELF_TEST_SIZE + d, n, -1, 0xa5)) {
+                printf("ERROR: memset() self test failed, offset %u, size %u\n",
+                       (unsigned int)d, (unsigned int)n);
+                return -1;
+            }
+        }
+    }
+
+    return 0;
+}
+
+#endif /* CONFIG_ELFLOADER_STRING_SELF_TEST */
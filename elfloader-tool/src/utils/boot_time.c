@@ -0,0 +1,145 @@
+/*
+ * Copyright 2020, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ */
+
+#include <autoconf.h>
+#include <elfloader/gen_config.h>
+
+#ifdef CONFIG_ELFLOADER_BOOT_TIME
+#include <types.h>
+#include <printf.h>
+#include <fdt.h>
+#include <elfloader_common.h>
+
+#include "../boot_time.h"
+
+struct boot_time_record {
+    uint32_t event;
+    uint32_t arg;
+    uint64_t time;
+};
+
+static char const *const boot_time_names[BOOT_TIME_NUM_EVENTS] = {
+    [BOOT_TIME_START] = "start",
+    [BOOT_TIME_DEVICES] = "devices",
+    [BOOT_TIME_ARCHIVE] = "archive",
+    [BOOT_TIME_HASH] = "hash",
+    [BOOT_TIME_SEGMENT] = "segment",
+    [BOOT_TIME_IMAGE] = "image",
+    [BOOT_TIME_PAGE_TABLES] = "page tables",
+    [BOOT_TIME_CACHES] = "caches",
+    [BOOT_TIME_SMP] = "smp",
+    [BOOT_TIME_KERNEL_ENTRY] = "kernel entry",
+};
+
+static struct boot_time_record boot_time_records[BOOT_TIME_MAX_RECORDS];
+static unsigned int boot_time_count;
+static unsigned int boot_time_dropped;
+
+/* Data of the property in the DTB, NULL if there is none */
+static uint32_t *boot_time_fdt_data;
+static uint64_t boot_time_freq;
+
+static void boot_time_fdt_set(unsigned int cell, uint32_t val)
+{
+    /* DTB cells are big endian, the byte swap is its own inverse. */
+    boot_time_fdt_data[cell] = be32_to_le(val);
+}
+
+static void boot_time_fdt_record(unsigned int i)
+{
+    struct boot_time_record const *r = &boot_time_records[i];
+    unsigned int cell = BOOT_TIME_HEADER_CELLS + i * BOOT_TIME_RECORD_CELLS;
+
+    boot_time_fdt_set(cell, r->event);
+    boot_time_fdt_set(cell + 1, r->arg);
+    boot_time_fdt_set(cell + 2, r->time >> 32);
+    boot_time_fdt_set(cell + 3, (uint32_t)r->time);
+    boot_time_fdt_set(1, i + 1);
+}
+
+void boot_time_mark(enum boot_time_event event, uint32_t arg)
+{
+    uint64_t time = arch_boot_time_counter();
+
+    /* The last record is kept for the kernel entry. */
+    if (boot_time_count >= BOOT_TIME_MAX_RECORDS - 1 &&
+        (event != BOOT_TIME_KERNEL_ENTRY || boot_time_count == BOOT_TIME_MAX_RECORDS)) {
+        boot_time_dropped++;
+        return;
+    }
+
+    boot_time_records[boot_time_count] = (struct boot_time_record) {
+        .event = event,
+        .arg = arg,
+        .time = time,
+    };
+    if (boot_time_fdt_data) {
+        boot_time_fdt_record(boot_time_count);
+    }
+    boot_time_count++;
+}
+
+size_t boot_time_attach_fdt(void *fdt, size_t size, size_t space)
+{
+    uint32_t *data = fdt_add_property(fdt, space, "chosen", BOOT_TIME_FDT_PROPERTY,
+                                      BOOT_TIME_DATA_SIZE);
+    if (!data) {
+        printf("Could not add the boot time records to the DTB\n");
+        return size;
+    }
+
+    boot_time_freq = arch_boot_time_frequency(fdt);
+    boot_time_fdt_data = data;
+    boot_time_fdt_set(0, BOOT_TIME_VERSION);
+    boot_time_fdt_set(2, boot_time_freq >> 32);
+    boot_time_fdt_set(3, (uint32_t)boot_time_freq);
+    for (unsigned int i = 0; i < boot_time_count; i++) {
+        boot_time_fdt_record(i);
+    }
+
+    return fdt_size(fdt);
+}
+
+/* Convert counter ticks to microseconds without overflowing for long times */
+static uint64_t boot_time_us(uint64_t ticks)
+{
+    return ticks / boot_time_freq * 1000000 +
+           ticks % boot_time_freq * 1000000 / boot_time_freq;
+}
+
+void boot_time_print(void)
+{
+    if (!boot_time_fdt_data) {
+        boot_time_freq = arch_boot_time_frequency(NULL);
+    }
+
+    printf("Boot time, counter frequency %"PRIu64" Hz:\n", boot_time_freq);
+    for (unsigned int i = 0; i < boot_time_count; i++) {
+        struct boot_time_record const *r = &boot_time_records[i];
+        /* The first record is the time since the counter started. */
+        uint64_t ticks = r->time - (i ? boot_time_records[i - 1].time : 0);
+
+        printf("  %s", boot_time_names[r->event]);
+        if (r->event == BOOT_TIME_SEGMENT || r->event == BOOT_TIME_IMAGE) {
+            printf(" %u", r->arg);
+        }
+        printf(": %"PRIu64" ticks", ticks);
+        if (boot_time_freq) {
+            printf(", %"PRIu64" us", boot_time_us(ticks));
+        }
+        printf("\n");
+    }
+    if (boot_time_count > 0 && boot_time_freq) {
+        printf("  total since start: %"PRIu64" us\n",
+               boot_time_us(boot_time_records[boot_time_count - 1].time -
+                            boot_time_records[0].time));
+    }
+    if (boot_time_dropped) {
+        printf("  %u records dropped\n", boot_time_dropped);
+    }
+}
+
+#endif /* CONFIG_ELFLOADER_BOOT_TIME */
@@ -0,0 +1,154 @@
+/*
+ * Copyright 2020, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ */
+
+#include <types.h>
+#include <strops.h>
+#include <printf.h>
+#include <elfloader_common.h>
+#include <cpio/cpio.h>
+
+#include "../cpio_index.h"
+
+struct cpio_index_entry {
+    uint32_t name_hash;
+    char const *name;
+    void const *data;
+    size_t size;
+};
+
+/* The entries of the index are taken from this pool. */
+static struct cpio_index_entry cpio_index_pool[CPIO_INDEX_MAX_ENTRIES];
+
+static struct {
+    void const *archive;
+    size_t len;
+    /* Number of members in the archive, may exceed CPIO_INDEX_MAX_ENTRIES. */
+    unsigned int num_members;
+    /* Number of indexed members, at most CPIO_INDEX_MAX_ENTRIES. */
+    unsigned int num_entries;
+} cpio_index;
+
+/* 32-bit FNV-1a */
+static uint32_t name_hash(char const *name)
+{
+    uint32_t hash = 2166136261u;
+
+    for (; *name; name++) {
+        hash ^= (uint8_t)*name;
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+int cpio_index_init(
+    void const *archive,
+    size_t len)
+{
+    _Static_assert(sizeof(unsigned long) <= sizeof(size_t),
+                   "integer model mismatch");
+
+    cpio_index.archive = archive;
+    cpio_index.len = len;
+    cpio_index.num_members = 0;
+    cpio_index.num_entries = 0;
+
+    /* Index the first members and only count the ones that do not fit. The
+     * counts are set at the end, so a malformed archive is never used. */
+    struct cpio_header *header = (struct cpio_header *)archive;
+    unsigned int n = 0;
+    for (;;) {
+        struct cpio_header_info info;
+        int ret = cpio_parse_header(header, len, &info);
+        if (ret == 1) {
+            break;
+        }
+        if (ret != 0) {
+            printf("ERROR: CPIO archive member %u invalid\n", n);
+            return -1;
+        }
+
+        if (n < CPIO_INDEX_MAX_ENTRIES) {
+            cpio_index_pool[n] = (struct cpio_index_entry) {
+                .name_hash = name_hash(info.filename),
+                .name = info.filename,
+                .data = info.data,
+                .size = (size_t)info.filesize,
+            };
+        }
+        n++;
+
+        len -= (uintptr_t)info.next - (uintptr_t)header;
+        header = info.next;
+    }
+
+    cpio_index.num_members = n;
+    cpio_index.num_entries = MIN(n, CPIO_INDEX_MAX_ENTRIES);
+    if (n > cpio_index.num_entries) {
+        log_info("CPIO archive has %u members, only %u are indexed\n",
+                 n, cpio_index.num_entries);
+    }
+
+    return (int)n;
+}
+
+void const *cpio_index_get_file(
+    char const *name,
+    size_t *size)
+{
+    uint32_t hash = name_hash(name);
+
+    for (unsigned int i = 0; i < cpio_index.num_entries; i++) {
+        struct cpio_index_entry const *entry = &cpio_index_pool[i];
+        if (entry->name_hash == hash && strcmp(entry->name, name) == 0) {
+            if (size) {
+                *size = entry->size;
+            }
+            return entry->data;
+        }
+    }
+
+    if (cpio_index.num_members > cpio_index.num_entries) {
+        unsigned long file_size = 0;
+        void const *data = cpio_get_file(cpio_index.archive, cpio_index.len,
+                                         name, &file_size);
+        if (data && size) {
+            *size = (size_t)file_size;
+        }
+        return data;
+    }
+
+    return NULL;
+}
+
+void const *cpio_index_get_entry(
+    unsigned int n,
+    char const **name,
+    size_t *size)
+{
+    if (n >= cpio_index.num_members) {
+        return NULL;
+    }
+
+    if (n >= cpio_index.num_entries) {
+        unsigned long file_size = 0;
+        void const *data = cpio_get_entry(cpio_index.archive, cpio_index.len,
+                                          n, name, &file_size);
+        if (data && size) {
+            *size = (size_t)file_size;
+        }
+        return data;
+    }
+
+    struct cpio_index_entry const *entry = &cpio_index_pool[n];
+    if (name) {
+        *name = entry->name;
+    }
+    if (size) {
+        *size = entry->size;
+    }
+    return entry->data;
+}
@@ -0,0 +1,164 @@
+/*
+ * Copyright 2020, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ */
+
+/*
+ * BLAKE2s-256 without a key, as specified in RFC 7693.
+ */
+#include <types.h>
+#include <strops.h>
+
+#include "../crypt_blake2s.h"
+#include "../crypt_copy.h"
+
+#define BLAKE2S_BLOCK_SIZE  64
+#define BLAKE2S_OUT_SIZE    32
+
+static const uint32_t IV[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+    0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+static const uint8_t SIGMA[10][16] = {
+    {  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15 },
+    { 14, 10,  4,  8,  9, 15, 13,  6,  1, 12,  0,  2, 11,  7,  5,  3 },
+    { 11,  8, 12,  0,  5,  2, 15, 13, 10, 14,  3,  6,  7,  1,  9,  4 },
+    {  7,  9,  3,  1, 13, 12, 11, 14,  2,  6,  5, 10,  4,  0, 15,  8 },
+    {  9,  0,  5,  7,  2,  4, 10, 15, 14,  1, 11, 12,  6,  8,  3, 13 },
+    {  2, 12,  6, 10,  0, 11,  8,  3,  4, 13,  7,  5, 15, 14,  1,  9 },
+    { 12,  5,  1, 15, 14, 13,  4, 10,  0,  7,  6,  3,  9,  2,  8, 11 },
+    { 13, 11,  7, 14, 12,  1,  3,  9,  5,  0, 15,  4,  8,  6,  2, 10 },
+    {  6, 15, 14,  9, 11,  3,  0,  8, 12,  2, 13,  7,  1,  4, 10,  5 },
+    { 10,  2,  8,  4,  7,  6,  1,  5, 15, 11,  9, 14,  3, 12, 13,  0 },
+};
+
+static uint32_t ror(uint32_t n, int k)
+{
+    return (n >> k) | (n << (32 - k));
+}
+
+#define G(a, b, c, d, x, y)         \
+    do {                            \
+        a = a + b + (x);            \
+        d = ror(d ^ a, 16);         \
+        c = c + d;                  \
+        b = ror(b ^ c, 12);         \
+        a = a + b + (y);            \
+        d = ror(d ^ a, 8);          \
+        c = c + d;                  \
+        b = ror(b ^ c, 7);          \
+    } while (0)
+
+/* Hash a block and, if 'copy' is not NULL, copy it there on the way. */
+static void processblock(blake2s_t *s, const uint8_t *buf, int last, uint8_t *copy)
+{
+    uint32_t m[16], v[16];
+    int i;
+
+    for (i = 0; i < 16; i++) {
+        m[i] = crypt_load_le32(buf + 4 * i, copy ? copy + 4 * i : NULL);
+    }
+    for (i = 0; i < 8; i++) {
+        v[i] = s->h[i];
+        v[i + 8] = IV[i];
+    }
+    v[12] ^= s->t[0];
+    v[13] ^= s->t[1];
+    if (last) {
+        v[14] = ~v[14];
+    }
+
+    for (i = 0; i < 10; i++) {
+        const uint8_t *sigma = SIGMA[i];
+        G(v[0], v[4], v[8],  v[12], m[sigma[0]],  m[sigma[1]]);
+        G(v[1], v[5], v[9],  v[13], m[sigma[2]],  m[sigma[3]]);
+        G(v[2], v[6], v[10], v[14], m[sigma[4]],  m[sigma[5]]);
+        G(v[3], v[7], v[11], v[15], m[sigma[6]],  m[sigma[7]]);
+        G(v[0], v[5], v[10], v[15], m[sigma[8]],  m[sigma[9]]);
+        G(v[1], v[6], v[11], v[12], m[sigma[10]], m[sigma[11]]);
+        G(v[2], v[7], v[8],  v[13], m[sigma[12]], m[sigma[13]]);
+        G(v[3], v[4], v[9],  v[14], m[sigma[14]], m[sigma[15]]);
+    }
+
+    for (i = 0; i < 8; i++) {
+        s->h[i] ^= v[i] ^ v[i + 8];
+    }
+}
+
+static void increment(blake2s_t *s, uint32_t n)
+{
+    s->t[0] += n;
+    if (s->t[0] < n) {
+        s->t[1]++;
+    }
+}
+
+void blake2s_init(blake2s_t *s)
+{
+    int i;
+
+    for (i = 0; i < 8; i++) {
+        s->h[i] = IV[i];
+    }
+    /* Parameter block: digest length, no key, fanout and depth 1 */
+    s->h[0] ^= 0x01010000 | BLAKE2S_OUT_SIZE;
+    s->t[0] = 0;
+    s->t[1] = 0;
+    s->buflen = 0;
+}
+
+void blake2s_sum(blake2s_t *s, uint8_t *md)
+{
+    int i;
+
+    increment(s, s->buflen);
+    memset(s->buf + s->buflen, 0, BLAKE2S_BLOCK_SIZE - s->buflen);
+    processblock(s, s->buf, 1, NULL);
+    for (i = 0; i < 8; i++) {
+        md[4 * i] = s->h[i];
+        md[4 * i + 1] = s->h[i] >> 8;
+        md[4 * i + 2] = s->h[i] >> 16;
+        md[4 * i + 3] = s->h[i] >> 24;
+    }
+}
+
+void blake2s_update(blake2s_t *s, const void *m, unsigned long len)
+{
+    blake2s_update_copy(s, NULL, m, len);
+}
+
+void blake2s_update_copy(blake2s_t *s, void *dest, const void *m, unsigned long len)
+{
+    const uint8_t *p = m;
+    uint8_t *d = dest;
+    unsigned long fill = BLAKE2S_BLOCK_SIZE - s->buflen;
+
+    /* The last block is processed differently, so a full block is kept in the
+     * buffer until more data arrives. Buffered data is copied from there. */
+    if (len > fill) {
+        memcpy(s->buf + s->buflen, p, fill);
+        if (d) {
+            memcpy(d, s->buf + s->buflen, fill);
+            d += fill;
+        }
+        s->buflen = 0;
+        increment(s, BLAKE2S_BLOCK_SIZE);
+        processblock(s, s->buf, 0, NULL);
+        len -= fill;
+        p += fill;
+        for (; len > BLAKE2S_BLOCK_SIZE; len -= BLAKE2S_BLOCK_SIZE, p += BLAKE2S_BLOCK_SIZE) {
+            increment(s, BLAKE2S_BLOCK_SIZE);
+            processblock(s, p, 0, d);
+            if (d) {
+                d += BLAKE2S_BLOCK_SIZE;
+            }
+        }
+    }
+    memcpy(s->buf + s->buflen, p, len);
+    if (d) {
+        memcpy(d, s->buf + s->buflen, len);
+    }
+    s->buflen += len;
+}
@@ -22,6 +22,7 @@
 #include <printf.h>
 #include <types.h>
 #include "../crypt_md5.h"
+#include "../crypt_copy.h"
 
 /* public domain md5 implementation based on rfc1321 and libtomcrypt */
 
@@ -49,15 +50,13 @@ static const uint32_t tab[64] = {
     0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1, 0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391
 };
 
-static void processblock(md5_t *s, const uint8_t *buf)
+/* Hash a block and, if 'copy' is not NULL, copy it there on the way. */
+static void processblock(md5_t *s, const uint8_t *buf, uint8_t *copy)
 {
     uint32_t i, W[16], a, b, c, d;
 
     for (i = 0; i < 16; i++) {
-        W[i] = buf[4 * i];
-        W[i] |= (uint32_t)buf[4 * i + 1] << 8;
-        W[i] |= (uint32_t)buf[4 * i + 2] << 16;
-        W[i] |= (uint32_t)buf[4 * i + 3] << 24;
+        W[i] = crypt_load_le32(buf + 4 * i, copy ? copy + 4 * i : NULL);
     }
 
     a = s->h[0];
@@ -121,7 +120,7 @@ static void pad(md5_t *s)
     if (r > 56) {
         memset(s->buf + r, 0, 64 - r);
         r = 0;
-        processblock(s, s->buf);
+        processblock(s, s->buf, NULL);
     }
     memset(s->buf + r, 0, 56 - r);
     s->len *= 8;
@@ -133,7 +132,7 @@ static void pad(md5_t *s)
     s->buf[61] = s->len >> 40;
     s->buf[62] = s->len >> 48;
     s->buf[63] = s->len >> 56;
-    processblock(s, s->buf);
+    processblock(s, s->buf, NULL);
 }
 
 void md5_init(md5_t *s)
@@ -159,22 +158,39 @@ void md5_sum(md5_t *s, uint8_t *md)
 }
 
 void md5_update(md5_t *s, const void *m, unsigned long len)
+{
+    md5_update_copy(s, NULL, m, len);
+}
+
+void md5_update_copy(md5_t *s, void *dest, const void *m, unsigned long len)
 {
     const uint8_t *p = m;
+    uint8_t *d = dest;
     unsigned r = s->len % 64;
     s->len += len;
     if (r) {
+        /* Partial blocks are copied from the block buffer. */
+        unsigned long n = (len < 64 - r) ? len : 64 - r;
+        memcpy(s->buf + r, p, n);
+        if (d) {
+            memcpy(d, s->buf + r, n);
+            d += n;
+        }
         if (len < 64 - r) {
-            memcpy(s->buf + r, p, len);
             return;
         }
-        memcpy(s->buf + r, p, 64 - r);
-        len -= 64 - r;
-        p += 64 - r;
-        processblock(s, s->buf);
+        len -= n;
+        p += n;
+        processblock(s, s->buf, NULL);
     }
     for (; len >= 64; len -= 64, p += 64) {
-        processblock(s, p);
+        processblock(s, p, d);
+        if (d) {
+            d += 64;
+        }
     }
     memcpy(s->buf, p, len);
+    if (d) {
+        memcpy(d, s->buf, len);
+    }
 }
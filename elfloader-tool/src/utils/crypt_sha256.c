@@ -22,8 +22,10 @@
 #include <printf.h>
 #include <types.h>
 #include <strops.h>
+#include <elfloader_common.h>
 
 #include "../crypt_sha256.h"
+#include "../crypt_copy.h"
 
 #define KEY_MAX 256
 #define SALT_MAX 16
@@ -55,16 +57,14 @@ static const uint32_t K[64] = {
     0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
 };
 
-static void processblock(sha256_t *s, const uint8_t *buf)
+/* Hash a block and, if 'copy' is not NULL, copy it there on the way. */
+static void processblock(sha256_t *s, const uint8_t *buf, uint8_t *copy)
 {
     uint32_t W[64], t1, t2, a, b, c, d, e, f, g, h;
     int i;
 
     for (i = 0; i < 16; i++) {
-        W[i] = (uint32_t)buf[4 * i] << 24;
-        W[i] |= (uint32_t)buf[4 * i + 1] << 16;
-        W[i] |= (uint32_t)buf[4 * i + 2] << 8;
-        W[i] |= buf[4 * i + 3];
+        W[i] = crypt_load_be32(buf + 4 * i, copy ? copy + 4 * i : NULL);
     }
     for (; i < 64; i++) {
         W[i] = R1(W[i - 2]) + W[i - 7] + R0(W[i - 15]) + W[i - 16];
@@ -99,6 +99,39 @@ static void processblock(sha256_t *s, const uint8_t *buf)
     s->h[7] += h;
 }
 
+/*
+ * Architectures can provide a faster way to process 'n' consecutive blocks,
+ * e.g. with cryptographic instructions. If 'copy' is not NULL, the blocks are
+ * copied there as they are loaded. This returns the number of blocks
+ * processed, which is 0 if the hardware doesn't support it.
+ */
+WEAK unsigned long arch_sha256_blocks(uint32_t h[8], const uint8_t *buf,
+                                      unsigned long n, uint8_t *copy)
+{
+    (void)h;
+    (void)buf;
+    (void)n;
+    (void)copy;
+    return 0;
+}
+
+static void processblocks(sha256_t *s, const uint8_t *buf, unsigned long n,
+                          uint8_t *copy)
+{
+    unsigned long done = arch_sha256_blocks(s->h, buf, n, copy);
+
+    buf += 64 * done;
+    if (copy) {
+        copy += 64 * done;
+    }
+    for (; done < n; done++, buf += 64) {
+        processblock(s, buf, copy);
+        if (copy) {
+            copy += 64;
+        }
+    }
+}
+
 static void pad(sha256_t *s)
 {
     unsigned r = s->len % 64;
@@ -107,7 +140,7 @@ static void pad(sha256_t *s)
     if (r > 56) {
         memset(s->buf + r, 0, 64 - r);
         r = 0;
-        processblock(s, s->buf);
+        processblocks(s, s->buf, 1, NULL);
     }
     memset(s->buf + r, 0, 56 - r);
     s->len *= 8;
@@ -119,7 +152,7 @@ static void pad(sha256_t *s)
     s->buf[61] = s->len >> 16;
     s->buf[62] = s->len >> 8;
     s->buf[63] = s->len;
-    processblock(s, s->buf);
+    processblocks(s, s->buf, 1, NULL);
 }
 
 void sha256_init(sha256_t *s)
@@ -149,23 +182,42 @@ void sha256_sum(sha256_t *s, uint8_t *md)
 }
 
 void sha256_update(sha256_t *s, const void *m, unsigned long len)
+{
+    sha256_update_copy(s, NULL, m, len);
+}
+
+void sha256_update_copy(sha256_t *s, void *dest, const void *m, unsigned long len)
 {
     const uint8_t *p = m;
+    uint8_t *d = dest;
     unsigned r = s->len % 64;
 
     s->len += len;
     if (r) {
+        /* Partial blocks are copied from the block buffer. */
+        unsigned long n = (len < 64 - r) ? len : 64 - r;
+        memcpy(s->buf + r, p, n);
+        if (d) {
+            memcpy(d, s->buf + r, n);
+            d += n;
+        }
         if (len < 64 - r) {
-            memcpy(s->buf + r, p, len);
             return;
         }
-        memcpy(s->buf + r, p, 64 - r);
-        len -= 64 - r;
-        p += 64 - r;
-        processblock(s, s->buf);
+        len -= n;
+        p += n;
+        processblocks(s, s->buf, 1, NULL);
     }
-    for (; len >= 64; len -= 64, p += 64) {
-        processblock(s, p);
+    if (len >= 64) {
+        processblocks(s, p, len / 64, d);
+        if (d) {
+            d += len - len % 64;
+        }
+        p += len - len % 64;
+        len %= 64;
     }
     memcpy(s->buf, p, len);
+    if (d) {
+        memcpy(d, s->buf, len);
+    }
 }
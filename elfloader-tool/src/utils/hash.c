@@ -12,9 +12,14 @@
 
 #include <printf.h>
 #include <types.h>
+#include <strops.h>
+#include <elfloader_common.h>
 
 #include "../hash.h"
 
+/* hash_update_copy() polls the console after each chunk of this size. */
+#define HASH_COPY_CHUNK 4096
+
 /* Function to perform all hash operations.
  *
  * The outputted hash is stored in the outputted_hash pointer after the "sum"
@@ -27,16 +32,76 @@ void get_hash(
     size_t len,
     void *outputted_hash)
 {
-    if (hashes.hash_type == SHA_256) {
-        sha256_t calculated_hash = hashes.sha_structure;
-        sha256_init(&calculated_hash);
-        sha256_update(&calculated_hash, data, len);
-        sha256_sum(&calculated_hash, outputted_hash);
+    hash_init(&hashes);
+    hash_update(&hashes, data, len);
+    hash_sum(&hashes, outputted_hash);
+}
+
+void hash_init(
+    hashes_t *hashes)
+{
+    if (hashes->hash_type == SHA_256) {
+        sha256_init(&hashes->sha_structure);
+    } else if (hashes->hash_type == BLAKE2S) {
+        blake2s_init(&hashes->blake2s_structure);
+    } else {
+        md5_init(&hashes->md5_structure);
+    }
+}
+
+void hash_update(
+    hashes_t *hashes,
+    const void *data,
+    size_t len)
+{
+    if (hashes->hash_type == SHA_256) {
+        sha256_update(&hashes->sha_structure, data, len);
+    } else if (hashes->hash_type == BLAKE2S) {
+        blake2s_update(&hashes->blake2s_structure, data, len);
+    } else {
+        md5_update(&hashes->md5_structure, data, len);
+    }
+}
+
+/* Function to hash data while copying it to 'dest'. The block functions of the
+ * hashes store each word to 'dest' as they load it, so the source is only read
+ * from memory once, with or without the caches.
+ */
+void hash_update_copy(
+    hashes_t *hashes,
+    void *dest,
+    const void *src,
+    size_t len)
+{
+    char *d = dest;
+    char const *s = src;
+
+    while (len > 0) {
+        size_t n = (len < HASH_COPY_CHUNK) ? len : HASH_COPY_CHUNK;
+        if (hashes->hash_type == SHA_256) {
+            sha256_update_copy(&hashes->sha_structure, d, s, n);
+        } else if (hashes->hash_type == BLAKE2S) {
+            blake2s_update_copy(&hashes->blake2s_structure, d, s, n);
+        } else {
+            md5_update_copy(&hashes->md5_structure, d, s, n);
+        }
+        console_poll();
+        d += n;
+        s += n;
+        len -= n;
+    }
+}
+
+void hash_sum(
+    hashes_t *hashes,
+    void *outputted_hash)
+{
+    if (hashes->hash_type == SHA_256) {
+        sha256_sum(&hashes->sha_structure, outputted_hash);
+    } else if (hashes->hash_type == BLAKE2S) {
+        blake2s_sum(&hashes->blake2s_structure, outputted_hash);
     } else {
-        md5_t calculated_hash = hashes.md5_structure;
-        md5_init(&calculated_hash);
-        md5_update(&calculated_hash, data, len);
-        md5_sum(&calculated_hash, outputted_hash);
+        md5_sum(&hashes->md5_structure, outputted_hash);
     }
 }
 
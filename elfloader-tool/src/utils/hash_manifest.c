@@ -0,0 +1,143 @@
+/*
+ * Copyright 2020, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ */
+
+#include <types.h>
+#include <strops.h>
+#include <printf.h>
+#include <binaries/elf/elf.h>
+
+#include "../hash_manifest.h"
+
+/* Largest digest of the supported hash algorithms */
+#define HASH_MANIFEST_MAX_DIGEST    32
+
+static int digest_equal(uint8_t const *a, uint8_t const *b, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        if (a[i] != b[i]) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void put_le(uint8_t *buf, uint64_t val, unsigned int size)
+{
+    for (unsigned int i = 0; i < size; i++) {
+        buf[i] = (uint8_t)(val >> (8 * i));
+    }
+}
+
+int hash_manifest_open(
+    struct hash_manifest *m,
+    hashes_t hashes,
+    size_t digest_size,
+    void const *manifest,
+    size_t manifest_size,
+    void const *elf)
+{
+    struct hash_manifest_header const *header = manifest;
+    uint8_t digest[HASH_MANIFEST_MAX_DIGEST];
+    uint8_t phdr[4 + 4 * 8];
+
+    if (manifest_size < sizeof(*header) ||
+        strncmp(header->magic, HASH_MANIFEST_MAGIC, sizeof(header->magic)) != 0) {
+        printf("ERROR: hash manifest header invalid\n");
+        return -1;
+    }
+
+    size_t max_chunks = (manifest_size - sizeof(*header)) / digest_size;
+    if (header->version != HASH_MANIFEST_VERSION ||
+        header->digest_size != digest_size ||
+        digest_size > sizeof(digest) ||
+        header->chunk_size == 0 ||
+        max_chunks == 0 ||
+        header->num_chunks != max_chunks - 1 ||
+        (manifest_size - sizeof(*header)) % digest_size != 0) {
+        printf("ERROR: hash manifest header invalid\n");
+        return -1;
+    }
+
+    m->hashes = hashes;
+    hash_init(&m->hashes);
+    for (unsigned int i = 0; i < elf_getNumProgramHeaders(elf); i++) {
+        put_le(&phdr[0], elf_getProgramHeaderType(elf, i), 4);
+        put_le(&phdr[4], elf_getProgramHeaderPaddr(elf, i), 8);
+        put_le(&phdr[12], elf_getProgramHeaderVaddr(elf, i), 8);
+        put_le(&phdr[20], elf_getProgramHeaderFileSize(elf, i), 8);
+        put_le(&phdr[28], elf_getProgramHeaderMemorySize(elf, i), 8);
+        hash_update(&m->hashes, phdr, sizeof(phdr));
+    }
+    put_le(phdr, elf_getEntryPoint(elf), 8);
+    hash_update(&m->hashes, phdr, 8);
+    hash_sum(&m->hashes, digest);
+
+    uint8_t const *digests = (uint8_t const *)manifest + sizeof(*header);
+    if (!digest_equal(digest, digests, digest_size)) {
+        printf("ERROR: program headers do not match the hash manifest\n");
+        return -1;
+    }
+
+    m->digest_size = digest_size;
+    m->digest = digests + digest_size;
+    m->chunk_size = header->chunk_size;
+    m->chunks_left = header->num_chunks;
+
+    return 0;
+}
+
+int hash_manifest_load(
+    struct hash_manifest *m,
+    void *dest,
+    void const *src,
+    size_t size)
+{
+    uint8_t digest[HASH_MANIFEST_MAX_DIGEST];
+    uint8_t *d = dest;
+    uint8_t const *s = src;
+
+    while (size > 0) {
+        size_t n = (size < m->chunk_size) ? size : m->chunk_size;
+
+        if (m->chunks_left == 0) {
+            printf("ERROR: image has more chunks than the hash manifest\n");
+            return -1;
+        }
+
+        hash_init(&m->hashes);
+        if (s) {
+            hash_update_copy(&m->hashes, d, s, n);
+            s += n;
+        } else {
+            hash_update(&m->hashes, d, n);
+        }
+        hash_sum(&m->hashes, digest);
+
+        if (!digest_equal(digest, m->digest, m->digest_size)) {
+            printf("ERROR: chunk at %p does not match the hash manifest\n", d);
+            return -1;
+        }
+
+        m->digest += m->digest_size;
+        m->chunks_left--;
+        d += n;
+        size -= n;
+    }
+
+    return 0;
+}
+
+int hash_manifest_close(
+    struct hash_manifest const *m)
+{
+    if (m->chunks_left != 0) {
+        printf("ERROR: %zu chunks of the hash manifest were not loaded\n",
+               m->chunks_left);
+        return -1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,44 @@
+/*
+ * Copyright 2020, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ */
+
+#include <types.h>
+#include <strops.h>
+
+#include "../load_plan.h"
+
+int load_plan_open(
+    struct load_plan *plan,
+    void const *blob,
+    size_t blob_size)
+{
+    uint8_t const *data = blob;
+
+    if (blob_size < sizeof(plan->header)) {
+        return -1;
+    }
+    memcpy(&plan->header, data, sizeof(plan->header));
+
+    if (strncmp(plan->header.magic, LOAD_PLAN_MAGIC,
+                sizeof(plan->header.magic)) != 0 ||
+        plan->header.version != LOAD_PLAN_VERSION ||
+        plan->header.num_ops > (blob_size - sizeof(plan->header)) /
+        sizeof(struct load_plan_op) ||
+        plan->header.min_vaddr > plan->header.max_vaddr ||
+        plan->header.min_paddr > plan->header.max_paddr) {
+        return -1;
+    }
+
+    plan->ops = data + sizeof(plan->header);
+    return 0;
+}
+
+void load_plan_get_op(
+    struct load_plan const *plan,
+    unsigned int i,
+    struct load_plan_op *op)
+{
+    memcpy(op, plan->ops + i * sizeof(*op), sizeof(*op));
+}
@@ -0,0 +1,182 @@
+/*
+ * Copyright 2020, Data61, CSIRO (ABN 41 687 119 230)
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ */
+
+/*
+ * Decoder for the LZ4 block format, see
+ * https://github.com/lz4/lz4/blob/dev/doc/lz4_Block_format.md
+ *
+ * The blocks are decompressed straight to the load address of the image, so
+ * all lengths and offsets are checked against both buffers.
+ */
+#include <types.h>
+#include <strops.h>
+#include <elfloader_common.h>
+
+#include "../lz4.h"
+
+#define LZ4_MIN_MATCH   4
+
+/*
+ * Add the extra bytes of a literal or match length to 'len'.
+ */
+static int lz4_read_length(
+    uint8_t const **ip,
+    uint8_t const *iend,
+    size_t *len)
+{
+    unsigned int b;
+
+    do {
+        if (*ip == iend) {
+            return -1;
+        }
+        b = *(*ip)++;
+        if (*len + b < *len) {
+            return -1;
+        }
+        *len += b;
+    } while (b == 255);
+
+    return 0;
+}
+
+int lz4_decompress_block(
+    void *dest,
+    size_t dest_size,
+    void const *src,
+    size_t src_size)
+{
+    uint8_t *op = dest;
+    uint8_t *const oend = op + dest_size;
+    uint8_t const *ip = src;
+    uint8_t const *const iend = ip + src_size;
+
+    while (ip < iend) {
+        unsigned int token = *ip++;
+
+        /* Literals */
+        size_t len = token >> 4;
+        if (len == 15 && lz4_read_length(&ip, iend, &len)) {
+            return -1;
+        }
+        if (len > (size_t)(iend - ip) || len > (size_t)(oend - op)) {
+            return -1;
+        }
+        memcpy(op, ip, len);
+        op += len;
+        ip += len;
+
+        /* The last sequence has no match */
+        if (ip == iend) {
+            break;
+        }
+
+        /* Match */
+        if (iend - ip < 2) {
+            return -1;
+        }
+        size_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > (size_t)(op - (uint8_t *)dest)) {
+            return -1;
+        }
+        len = token & 15;
+        if (len == 15 && lz4_read_length(&ip, iend, &len)) {
+            return -1;
+        }
+        len += LZ4_MIN_MATCH;
+        if (len > (size_t)(oend - op)) {
+            return -1;
+        }
+
+        /*
+         * The match may overlap the output. The data between 'match' and 'op'
+         * repeats with the period 'offset', so it can be copied in chunks that
+         * double in size.
+         */
+        uint8_t const *match = op - offset;
+        while (len > 0) {
+            size_t n = MIN(len, (size_t)(op - match));
+            memcpy(op, match, n);
+            op += n;
+            len -= n;
+        }
+    }
+
+    return (op == oend) ? 0 : -1;
+}
+
+void const *lz4_image_open(
+    void const *blob,
+    size_t blob_size,
+    struct lz4_image_stream *stream)
+{
+    struct lz4_image_header const *header = blob;
+
+    if (blob_size < sizeof(*header) ||
+        strncmp(header->magic, LZ4_IMAGE_MAGIC, sizeof(header->magic)) != 0) {
+        return NULL;
+    }
+
+    if (header->version != LZ4_IMAGE_VERSION ||
+        header->block_size == 0 ||
+        !IS_ALIGNED(header->elf_headers_size, 3) ||
+        header->elf_headers_size > blob_size - sizeof(*header)) {
+        return NULL;
+    }
+
+    uint8_t const *elf = (uint8_t const *)blob + sizeof(*header);
+    if (stream) {
+        stream->pos = elf + header->elf_headers_size;
+        stream->end = (uint8_t const *)blob + blob_size;
+        stream->block_size = header->block_size;
+        stream->elf_size = header->elf_size;
+    }
+
+    return elf;
+}
+
+int lz4_image_read(
+    struct lz4_image_stream *stream,
+    void *dest,
+    size_t size)
+{
+    uint8_t *out = dest;
+
+    while (size > 0) {
+        size_t n = MIN(size, stream->block_size);
+
+        if (stream->end - stream->pos < 4) {
+            return -1;
+        }
+        /* The block headers are not aligned. */
+        uint32_t block = (uint32_t)stream->pos[0] |
+                         ((uint32_t)stream->pos[1] << 8) |
+                         ((uint32_t)stream->pos[2] << 16) |
+                         ((uint32_t)stream->pos[3] << 24);
+        stream->pos += 4;
+
+        size_t block_size = block & ~LZ4_IMAGE_BLOCK_STORED;
+        if (block_size > (size_t)(stream->end - stream->pos)) {
+            return -1;
+        }
+
+        if (block & LZ4_IMAGE_BLOCK_STORED) {
+            if (block_size != n) {
+                return -1;
+            }
+            memcpy(out, stream->pos, n);
+        } else if (lz4_decompress_block(out, n, stream->pos, block_size)) {
+            return -1;
+        }
+
+        stream->pos += block_size;
+        out += n;
+        size -= n;
+    }
+
+    return 0;
+}